@@ -0,0 +1,194 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "allocator.h"
+
+
+static void *
+_libc_malloc(void *ptr, size_t size) {
+    return malloc(size);
+}
+
+
+static void *
+_libc_realloc(void *ptr, void *mem, size_t size) {
+    return realloc(mem, size);
+}
+
+
+static void
+_libc_free(void *ptr, void *mem) {
+    free(mem);
+}
+
+
+static const struct earg_allocator _libc = {
+    .malloc = _libc_malloc,
+    .realloc = _libc_realloc,
+    .free = _libc_free,
+    .ptr = NULL,
+};
+
+
+static const struct earg_allocator *_global = &_libc;
+
+
+void
+earg_allocator_set(const struct earg_allocator *allocator) {
+    _global = allocator? allocator: &_libc;
+}
+
+
+void *
+allocator_malloc(const struct earg_allocator *a, size_t size) {
+    a = a? a: _global;
+    return a->malloc(a->ptr, size);
+}
+
+
+void *
+allocator_calloc(const struct earg_allocator *a, size_t count,
+        size_t size) {
+    void *mem;
+
+    if (size && (count > (SIZE_MAX / size))) {
+        return NULL;
+    }
+
+    mem = allocator_malloc(a, count * size);
+    if (mem) {
+        memset(mem, 0, count * size);
+    }
+
+    return mem;
+}
+
+
+void *
+allocator_realloc(const struct earg_allocator *a, void *mem, size_t size) {
+    a = a? a: _global;
+    return a->realloc(a->ptr, mem, size);
+}
+
+
+void
+allocator_free(const struct earg_allocator *a, void *mem) {
+    if (mem == NULL) {
+        return;
+    }
+
+    a = a? a: _global;
+    a->free(a->ptr, mem);
+}
+
+
+/* counting allocator, each block is prefixed by its size */
+union header {
+    size_t size;
+    max_align_t align;
+};
+
+
+#define COUNT(f, v) __atomic_add_fetch(&(f), (v), __ATOMIC_RELAXED)
+
+
+static void
+_count(struct earg_countingallocator *a, size_t size) {
+    size_t current = COUNT(a->current, size);
+    size_t peak = __atomic_load_n(&a->peak, __ATOMIC_RELAXED);
+
+    COUNT(a->total, size);
+    COUNT(a->allocs, 1);
+    while ((current > peak) && !__atomic_compare_exchange_n(&a->peak, &peak,
+                current, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+
+static void *
+_counting_malloc(void *ptr, size_t size) {
+    struct earg_countingallocator *a = ptr;
+    const struct earg_allocator *b = a->backend? a->backend: &_libc;
+    union header *h;
+
+    h = b->malloc(b->ptr, sizeof(union header) + size);
+    if (h == NULL) {
+        return NULL;
+    }
+
+    h->size = size;
+    _count(a, size);
+    return h + 1;
+}
+
+
+static void *
+_counting_realloc(void *ptr, void *mem, size_t size) {
+    struct earg_countingallocator *a = ptr;
+    const struct earg_allocator *b = a->backend? a->backend: &_libc;
+    union header *h;
+    size_t old;
+
+    if (mem == NULL) {
+        return _counting_malloc(ptr, size);
+    }
+
+    h = (union header *)mem - 1;
+    old = h->size;
+    h = b->realloc(b->ptr, h, sizeof(union header) + size);
+    if (h == NULL) {
+        return NULL;
+    }
+
+    /* the whole new block is counted, as it's a new allocation */
+    h->size = size;
+    COUNT(a->current, -old);
+    _count(a, size);
+    return h + 1;
+}
+
+
+static void
+_counting_free(void *ptr, void *mem) {
+    struct earg_countingallocator *a = ptr;
+    const struct earg_allocator *b = a->backend? a->backend: &_libc;
+    union header *h = (union header *)mem - 1;
+
+    COUNT(a->current, -h->size);
+    b->free(b->ptr, h);
+}
+
+
+const struct earg_allocator *
+earg_countingallocator_init(struct earg_countingallocator *a,
+        const struct earg_allocator *backend) {
+    a->malloc = _counting_malloc;
+    a->realloc = _counting_realloc;
+    a->free = _counting_free;
+    a->ptr = a;
+    a->backend = backend;
+    a->total = 0;
+    a->allocs = 0;
+    a->current = 0;
+    a->peak = 0;
+    return (const struct earg_allocator *)a;
+}
@@ -0,0 +1,45 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef ALLOCATOR_H_
+#define ALLOCATOR_H_
+
+
+#include <stddef.h>
+
+#include "earg.h"
+
+
+/* NULL allocator means the global one, see earg_allocator_set() */
+void *
+allocator_malloc(const struct earg_allocator *a, size_t size);
+
+
+void *
+allocator_calloc(const struct earg_allocator *a, size_t count, size_t size);
+
+
+void *
+allocator_realloc(const struct earg_allocator *a, void *mem, size_t size);
+
+
+void
+allocator_free(const struct earg_allocator *a, void *mem);
+
+
+#endif  // ALLOCATOR_H_
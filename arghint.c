@@ -16,18 +16,17 @@
  *
  *  Author: Vahid Mardani <vahid.mardani@gmail.com>
  */
-#include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
-#include <limits.h>
 
 #include "arghint.h"
 
 
-#define ISSET(i, b) (i & (1 << (b)))
-#define SETBIT(i, b) (i |= (1 << (b)))
+#define ISSET(i, b) (i & (1U << (b)))
+#define SETBIT(i, b) (i |= (1U << (b)))
 #define MAXBITS 32
 #define MAXARGS (MAXBITS - 2)
-#define ARGSMASK (~(3 << MAXARGS))
+#define ARGSMASK ((int)~(3U << MAXARGS))
 
 
 int
@@ -60,43 +59,66 @@ arghint_validate(size_t count, int pattern) {
 }
 
 
-int
-arghint_parse(const char *args) {
-    char *arghint;
-    char *dots;
-    char *strtokstate;
-    char *tok;
+/* tokens of a single line, ends at the newline */
+static const char *
+_nexttok(const char *s, size_t *len) {
+    const char *e;
+
+    while (*s == ' ') {
+        s++;
+    }
+
+    if ((*s == 0) || (*s == '\n')) {
+        return NULL;
+    }
+
+    e = s;
+    while (*e && (*e != ' ') && (*e != '\n')) {
+        e++;
+    }
+
+    *len = e - s;
+    return s;
+}
+
+
+static const char *
+_dots(const char *tok, size_t toklen) {
+    int i;
+
+    for (i = 0; (i + 3) <= toklen; i++) {
+        if ((tok[i] == '.') && (tok[i + 1] == '.') && (tok[i + 2] == '.')) {
+            return tok + i;
+        }
+    }
+
+    return NULL;
+}
+
+
+static int
+_lineparse(const char *args) {
+    const char *dots;
+    const char *tok;
     size_t toklen;
     int counter = 0;
     int bits = 0;
     int opens = 0;
     int i;
 
-    if ((args == NULL) || (strlen(args) == 0)) {
-        SETBIT(bits, counter);
-        return bits;
-    }
-
-    arghint = strdup(args);
-    if (arghint == NULL) {
+    tok = _nexttok(args, &toklen);
+    if (tok == NULL) {
         return -1;
     }
 
-    tok = strtok_r(arghint, " ", &strtokstate);
-    if ((tok == NULL) || (strlen(tok) == 0)) {
-        free(arghint);
-        goto failed;
-    }
-
     do {
-        toklen = strlen(tok);
         if (tok[0] == '[') {
             SETBIT(bits, counter);
             opens++;
         }
         counter++;
         if (counter > MAXARGS) {
-            goto failed;
+            return -1;
         }
 
         i = toklen - 1;
@@ -108,10 +130,10 @@ arghint_parse(const char *args) {
             i--;
         }
 
-        dots = strstr(tok, "...");
+        dots = _dots(tok, toklen);
         if (dots) {
             if ((toklen - (dots - tok)) > 3) {
-                goto failed;
+                return -1;
             }
 
             if (tok == dots) {
@@ -122,24 +144,61 @@ arghint_parse(const char *args) {
             }
 
             SETBIT(bits, 31);
-            // bits |= 1 << 31;
-            goto terminate;
+            return bits;
         }
 
-        tok = strtok_r(NULL, " ", &strtokstate);
-    } while (tok && strlen(tok));
+        tok = _nexttok(tok + toklen, &toklen);
+    } while (tok);
 
     if (opens) {
-        goto failed;
+        return -1;
     }
 
     SETBIT(bits, counter);
-
-terminate:
-    free(arghint);
     return bits;
+}
 
-failed:
-    free(arghint);
-    return -1;
+
+/* Counts above the highest one of a variadic pattern are set, so the
+ * patterns of the lines may be ORed. */
+static int
+_variadicexpand(int pattern) {
+    int lastbit;
+
+    if (!ISSET(pattern, 31)) {
+        return pattern;
+    }
+
+    lastbit = (MAXBITS - __builtin_clz(pattern & ARGSMASK)) - 1;
+    return pattern | (ARGSMASK & ~((2U << lastbit) - 1));
+}
+
+
+/* Each line of a multi-line hint is an alternative usage, -1 if any of
+ * them is invalid, the count is not validated then. */
+int
+arghint_parse(const char *args) {
+    int bits = 0;
+    int line;
+
+    if ((args == NULL) || (args[0] == 0)) {
+        SETBIT(bits, 0);
+        return bits;
+    }
+
+    if (strchr(args, '\n') == NULL) {
+        return _lineparse(args);
+    }
+
+    do {
+        line = _lineparse(args);
+        if (line == -1) {
+            return -1;
+        }
+
+        bits |= _variadicexpand(line);
+        args = strchr(args, '\n');
+    } while (args && *(++args));
+
+    return bits;
 }
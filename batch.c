@@ -0,0 +1,230 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "earg.h"
+#include "allocator.h"
+#include "defaults.h"
+#include "responsefile.h"
+#include "state.h"
+#include "sink.h"
+
+
+struct worker {
+    const struct earg *earg;
+    const struct defaults *defaults;
+    pthread_t thread;
+    char *start;
+    struct earg_batchresult *results;
+    size_t first;
+    size_t count;
+
+    /* diagnostics are collected and flushed in order after the join */
+    struct sinkbuffer out;
+    struct sinkbuffer err;
+};
+
+
+static void *
+_worker(void *arg) {
+    struct worker *w = arg;
+    struct earg_batchresult *result;
+    earg_state_t state;
+    char *line = w->start;
+    char *eol;
+    int i;
+    struct earg_sink out = {.write = sink_collect, .ptr = &w->out};
+    struct earg_sink err = {.write = sink_collect, .ptr = &w->err};
+
+    state = allocator_malloc(w->earg->allocator, earg_state_size());
+    if (state == NULL) {
+        goto failed;
+    }
+    earg_state_init(state, earg_state_size());
+    earg_state_sinks(state, &out, &err);
+    state->defaults = w->defaults;
+
+    for (i = 0; i < w->count; i++) {
+        eol = strchr(line, '\n');
+        if (eol) {
+            *eol = 0;
+        }
+
+        result = w->results + i;
+        result->line = w->first + i + 1;
+        result->command = NULL;
+        result->status = earg_parse_line(w->earg, state, line,
+                &result->command);
+        result->verbosity = earg_state_verbosity(state);
+
+        line = eol? eol + 1: line + strlen(line);
+    }
+
+    allocator_free(w->earg->allocator, state);
+    return NULL;
+
+failed:
+    for (i = 0; i < w->count; i++) {
+        w->results[i].line = w->first + i + 1;
+        w->results[i].command = NULL;
+        w->results[i].status = EARG_FATAL;
+        w->results[i].verbosity = -1;
+    }
+
+    return NULL;
+}
+
+
+static size_t
+_lines_count(const char *buff) {
+    size_t count = 0;
+    const char *eol;
+
+    while (*buff) {
+        count++;
+        eol = strchr(buff, '\n');
+        if (eol == NULL) {
+            break;
+        }
+        buff = eol + 1;
+    }
+
+    return count;
+}
+
+
+ssize_t
+earg_parse_batch(const struct earg *c, char *buff,
+        struct earg_batchresult *results, size_t count, int workers) {
+    int i;
+    size_t j;
+    size_t line = 0;
+    size_t lines;
+    struct worker *pool;
+    struct defaults defaults;
+    char *start = buff;
+    char *eol;
+
+    if ((c == NULL) || (buff == NULL) || (c->plan == NULL)) {
+        return -1;
+    }
+
+    lines = _lines_count(buff);
+    if (results == NULL) {
+        return lines;
+    }
+
+    if (lines > count) {
+        return -1;
+    }
+
+    if (workers < 1) {
+        workers = 1;
+    }
+
+    if (workers > lines) {
+        workers = lines? lines: 1;
+    }
+
+    if (defaults_load(&defaults, c)) {
+        return -1;
+    }
+
+    pool = allocator_calloc(c->allocator, workers, sizeof(struct worker));
+    if (pool == NULL) {
+        defaults_dispose(&defaults, c);
+        return -1;
+    }
+
+    /* each worker gets a contiguous chunk of lines */
+    for (i = 0; i < workers; i++) {
+        pool[i].earg = c;
+        pool[i].defaults = &defaults;
+        pool[i].out.allocator = c->allocator;
+        pool[i].err.allocator = c->allocator;
+        pool[i].results = results + line;
+        pool[i].first = line;
+        pool[i].count = (lines * (i + 1)) / workers - line;
+        pool[i].start = start;
+
+        line += pool[i].count;
+        for (j = 0; (j < pool[i].count) && *start; j++) {
+            eol = strchr(start, '\n');
+            start = eol? eol + 1: start + strlen(start);
+        }
+
+        if ((i == 0) || pthread_create(&pool[i].thread, NULL, _worker,
+                    pool + i)) {
+            pool[i].thread = pthread_self();
+        }
+    }
+
+    /* the first chunk, and any chunk failed to get a thread, runs here */
+    for (i = 0; i < workers; i++) {
+        if (pthread_equal(pool[i].thread, pthread_self())) {
+            _worker(pool + i);
+        }
+    }
+
+    for (i = 0; i < workers; i++) {
+        if (!pthread_equal(pool[i].thread, pthread_self())) {
+            pthread_join(pool[i].thread, NULL);
+        }
+
+        if (pool[i].out.buff) {
+            fwrite(pool[i].out.buff, 1, pool[i].out.len, stdout);
+            allocator_free(c->allocator, pool[i].out.buff);
+        }
+
+        if (pool[i].err.buff) {
+            fwrite(pool[i].err.buff, 1, pool[i].err.len, stderr);
+            allocator_free(c->allocator, pool[i].err.buff);
+        }
+    }
+
+    allocator_free(c->allocator, pool);
+    defaults_dispose(&defaults, c);
+    return lines;
+}
+
+
+ssize_t
+earg_parse_batchfile(const struct earg *c, const char *path,
+        struct earg_batchresult *results, size_t count, int workers) {
+    struct responsefile *file;
+    ssize_t lines;
+
+    if ((c == NULL) || (path == NULL)) {
+        return -1;
+    }
+
+    file = responsefile_open(path, c->allocator);
+    if (file == NULL) {
+        return -1;
+    }
+
+    /* there is always a byte after the contents */
+    file->buff[file->len] = 0;
+    lines = earg_parse_batch(c, file->buff, results, count, workers);
+    responsefile_close(file, c->allocator);
+    return lines;
+}
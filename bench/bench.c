@@ -0,0 +1,643 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "earg.h"
+
+
+/* Benchmark of earg_parse() against synthetic command trees. Each command
+ * has the given number of options and sub-commands, argv walks down to
+ * the last leaf and is filled with a mix of long, short and positional
+ * arguments. The same argv goes through getopt_long() with all the
+ * options of the path in one table. */
+
+
+#define SHORTKEYS "abcdefgijklmnoprstuwxyz"
+#define NAMEMAX 32
+
+
+struct config {
+    unsigned int options;
+    unsigned int depth;
+    unsigned int siblings;
+    unsigned int argc;
+    unsigned int iterations;
+};
+
+
+static struct config config = {
+    .options = 8,
+    .depth = 3,
+    .siblings = 4,
+    .argc = 32,
+    .iterations = 100000,
+};
+
+
+static struct earg_option _options[] = {
+    {"options", 'o', "N", 0, "Options per command, default: 8",
+        EARG_TYPE_UINT, offsetof(struct config, options)},
+    {"depth", 'd', "N", 0, "Depth of the command tree, default: 3",
+        EARG_TYPE_UINT, offsetof(struct config, depth)},
+    {"siblings", 's', "N", 0, "Sub-commands per command, default: 4",
+        EARG_TYPE_UINT, offsetof(struct config, siblings)},
+    {"argc", 'a', "N", 0, "Length of argv, default: 32",
+        EARG_TYPE_UINT, offsetof(struct config, argc)},
+    {"iterations", 'n', "N", 0, "Parses per scenario, default: 100000",
+        EARG_TYPE_UINT, offsetof(struct config, iterations)},
+    {NULL}
+};
+
+
+static struct earg _cli = {
+    .options = _options,
+    .userptr = &config,
+    .header = "Measure earg_parse() against a synthetic command tree and "
+        "getopt_long() on the same arguments.",
+    .flags = EARG_NOELOG,
+};
+
+
+/* heap allocations, counted only if the linker wraps malloc, see
+ * bench/CMakeLists.txt */
+static size_t _allocs;
+#ifdef BENCH_WRAP_MALLOC
+void *
+__real_malloc(size_t size);
+
+
+void *
+__real_calloc(size_t count, size_t size);
+
+
+void *
+__real_realloc(void *ptr, size_t size);
+
+
+void *
+__wrap_malloc(size_t size) {
+    _allocs++;
+    return __real_malloc(size);
+}
+
+
+void *
+__wrap_calloc(size_t count, size_t size) {
+    _allocs++;
+    return __real_calloc(count, size);
+}
+
+
+void *
+__wrap_realloc(void *ptr, size_t size) {
+    _allocs++;
+    return __real_realloc(ptr, size);
+}
+#endif
+
+
+/* Everything of the tree lives in a few flat arrays */
+struct tree {
+    struct earg root;
+    struct earg_command *commands;
+    const struct earg_command **children;
+    struct earg_option *options;
+    char *strings;
+    size_t commandscount;
+    size_t childrencount;
+    size_t optionscount;
+    size_t stringslen;
+
+    /* argv, the same as a line and the getopt_long() tables */
+    const char **argv;
+    int argc;
+    int pathlen;
+    char *line;
+    size_t linelen;
+    struct option *longopts;
+    int longoptscount;
+    char shortopts[64];
+};
+
+
+static size_t _eaten;
+
+
+static enum earg_eatstatus
+_eat(const struct earg_option *option, const char *value, void *userptr) {
+    _eaten++;
+    return EARG_EAT_OK;
+}
+
+
+static int
+_discard(void *ptr, const char *data, size_t len) {
+    return 0;
+}
+
+
+static double
+_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+
+static const char *
+_string(struct tree *t, const char *fmt, ...) {
+    va_list args;
+    char *s = t->strings + t->stringslen;
+
+    va_start(args, fmt);
+    t->stringslen += vsnprintf(s, NAMEMAX, fmt, args) + 1;
+    va_end(args);
+    return s;
+}
+
+
+/* Options of level l are named l<l>-<i> so they're unique over any path,
+ * the root's first options get the short keys. Even ones take a value. */
+static void
+_options_build(struct tree *t, struct earg_command *cmd, int level) {
+    int i;
+    struct earg_option *opt = t->options + t->optionscount;
+    struct earg_option tmp;
+
+    for (i = 0; i < config.options; i++) {
+        memset(&tmp, 0, sizeof(tmp));
+        tmp.name = _string(t, "l%d-%d", level, i);
+        *(int *)&tmp.key = 256 + level * 256 + i;
+        if ((level == 0) && (i < (sizeof(SHORTKEYS) - 1))) {
+            *(int *)&tmp.key = SHORTKEYS[i];
+        }
+        tmp.arg = (i % 2)? NULL: "VALUE";
+        tmp.flags = EARG_OPTION_MULTIPLE;
+        tmp.help = "Lorem ipsum dolor sit amet, consectetur adipiscing elit, "
+            "sed do eiusmod tempor incididunt ut labore et dolore magna";
+        memcpy(opt + i, &tmp, sizeof(tmp));
+    }
+
+    memset(opt + i, 0, sizeof(struct earg_option));
+    t->optionscount += config.options + 1;
+    cmd->options = opt;
+}
+
+
+static void
+_command_build(struct tree *t, struct earg_command *cmd, int level) {
+    int i;
+    struct earg_command *child;
+    const struct earg_command **children;
+
+    _options_build(t, cmd, level);
+    cmd->args = "[ARG]...";
+    cmd->eat = _eat;
+    cmd->header = "Lorem ipsum dolor sit amet, consectetur adipiscing elit.";
+
+    if ((level + 1) >= config.depth) {
+        return;
+    }
+
+    children = t->children + t->childrencount;
+    t->childrencount += config.siblings + 1;
+    for (i = 0; i < config.siblings; i++) {
+        child = t->commands + t->commandscount++;
+        child->name = _string(t, "cmd%d-%d", level + 1, i);
+        children[i] = child;
+        _command_build(t, child, level + 1);
+    }
+    children[i] = NULL;
+    cmd->commands = children;
+}
+
+
+static void
+_longopts_add(struct tree *t, const struct earg_option *o) {
+    struct option *lo = t->longopts + t->longoptscount++;
+    int len;
+
+    lo->name = o->name;
+    lo->has_arg = o->arg? required_argument: no_argument;
+    lo->val = o->key;
+    if (o->key >= 256) {
+        return;
+    }
+
+    len = strlen(t->shortopts);
+    t->shortopts[len++] = o->key;
+    if (o->arg) {
+        t->shortopts[len++] = ':';
+    }
+    t->shortopts[len] = 0;
+}
+
+
+/* The path to the last leaf, then pseudo random arguments */
+static void
+_argv_build(struct tree *t) {
+    int i;
+    unsigned int r = 1;
+    const struct earg_command *cmd = (const struct earg_command *)&t->root;
+    const struct earg_option *o;
+    const struct option *lo;
+    const char *arg;
+
+    t->argv[t->argc++] = "bench";
+    for (;;) {
+        for (o = cmd->options; o->name; o++) {
+            _longopts_add(t, o);
+        }
+
+        if ((cmd->commands == NULL) || (t->argc >= config.argc)) {
+            break;
+        }
+
+        /* the last sibling is the farthest for a linear search */
+        cmd = cmd->commands[config.siblings - 1];
+        t->argv[t->argc++] = cmd->name;
+    }
+    t->pathlen = t->argc;
+
+    while (t->argc < config.argc) {
+        r = r * 1103515245 + 12345;
+        lo = t->longopts + ((r >> 8) % t->longoptscount);
+
+        switch ((r >> 20) % 4) {
+            case 0:
+                arg = _string(t, "arg%d", t->argc);
+                t->argv[t->argc++] = arg;
+                continue;
+
+            case 1:
+                if (lo->val < 256) {
+                    t->argv[t->argc++] = _string(t, "-%c", lo->val);
+                    break;
+                }
+                /* fallthrough */
+
+            default:
+                t->argv[t->argc++] = _string(t, "--%s", lo->name);
+        }
+
+        if ((lo->has_arg == required_argument) && (t->argc < config.argc)) {
+            t->argv[t->argc++] = "value";
+        }
+    }
+
+    for (i = 0; i < t->argc; i++) {
+        t->linelen += sprintf(t->line + t->linelen, "%s%s", i? " ": "",
+                t->argv[i]);
+    }
+}
+
+
+static int
+_tree_build(struct tree *t) {
+    size_t i;
+    size_t commands = 1;
+    size_t level = 1;
+
+    for (i = 1; i < config.depth; i++) {
+        level *= config.siblings;
+        commands += level;
+    }
+
+    memset(t, 0, sizeof(struct tree));
+    t->commands = calloc(commands, sizeof(struct earg_command));
+    t->children = calloc(commands * (config.siblings + 1),
+            sizeof(struct earg_command *));
+    t->options = calloc(commands * (config.options + 1),
+            sizeof(struct earg_option));
+    t->strings = malloc((commands * (config.options + 1) + config.argc) *
+            NAMEMAX);
+    t->argv = calloc(config.argc + 1, sizeof(char *));
+    t->line = malloc(config.argc * NAMEMAX);
+    t->longopts = calloc(config.options * config.depth + 1,
+            sizeof(struct option));
+    if ((t->commands == NULL) || (t->children == NULL) ||
+            (t->options == NULL) || (t->strings == NULL) ||
+            (t->argv == NULL) || (t->line == NULL) ||
+            (t->longopts == NULL)) {
+        return -1;
+    }
+
+    t->root.version = "1.0.0";
+    _command_build(t, (struct earg_command *)&t->root, 0);
+    _argv_build(t);
+    return 0;
+}
+
+
+static void
+_tree_dispose(struct tree *t) {
+    earg_dispose(&t->root);
+    earg_plan_dispose(&t->root);
+    free(t->commands);
+    free(t->children);
+    free(t->options);
+    free(t->strings);
+    free(t->argv);
+    free(t->line);
+    free(t->longopts);
+}
+
+
+static void
+_report(const char *scenario, const struct tree *t, double start,
+        size_t allocs, unsigned int iterations) {
+    double elapsed = _now() - start;
+
+    printf("%-16s %12.0f %10.2f %14.2f\n", scenario,
+           iterations * 1e9 / elapsed,
+           elapsed / ((double)iterations * (t->argc - 1)),
+#ifdef BENCH_WRAP_MALLOC
+           (double)(_allocs - allocs) / iterations
+#else
+           -1.0
+#endif
+           );
+}
+
+
+static int
+_earg_parse(struct tree *t) {
+    int i;
+    double start;
+    size_t allocs;
+
+    /* the first call allocates the state */
+    if (earg_parse(&t->root, t->argc, t->argv, NULL) != EARG_OK) {
+        return -1;
+    }
+
+    allocs = _allocs;
+    start = _now();
+    for (i = 0; i < config.iterations; i++) {
+        earg_parse(&t->root, t->argc, t->argv, NULL);
+    }
+    _report("earg_parse", t, start, allocs, config.iterations);
+    return 0;
+}
+
+
+static int
+_earg_parse_r(struct tree *t, earg_state_t state) {
+    int i;
+    double start;
+    size_t allocs;
+
+    if (earg_parse_r(&t->root, state, t->argc, t->argv, NULL) != EARG_OK) {
+        return -1;
+    }
+
+    allocs = _allocs;
+    start = _now();
+    for (i = 0; i < config.iterations; i++) {
+        earg_parse_r(&t->root, state, t->argc, t->argv, NULL);
+    }
+    _report("earg_parse_r", t, start, allocs, config.iterations);
+    return 0;
+}
+
+
+/* the line is split in place, so it's copied on each iteration */
+static int
+_earg_parse_line(struct tree *t, earg_state_t state) {
+    int i;
+    double start;
+    size_t allocs;
+    char *line = malloc(t->linelen + 1);
+
+    if (line == NULL) {
+        return -1;
+    }
+
+    memcpy(line, t->line, t->linelen + 1);
+    if (earg_parse_line(&t->root, state, line, NULL) != EARG_OK) {
+        free(line);
+        return -1;
+    }
+
+    allocs = _allocs;
+    start = _now();
+    for (i = 0; i < config.iterations; i++) {
+        memcpy(line, t->line, t->linelen + 1);
+        earg_parse_line(&t->root, state, line, NULL);
+    }
+    _report("earg_parse_line", t, start, allocs, config.iterations);
+    free(line);
+    return 0;
+}
+
+
+/* getopt_long() permutes argv, so it's copied on each iteration */
+static int
+_getopt_long(struct tree *t) {
+    int i;
+    double start;
+    size_t allocs;
+    char **argv = malloc(sizeof(char *) * (t->argc + 1));
+
+    if (argv == NULL) {
+        return -1;
+    }
+
+    opterr = 0;
+    allocs = _allocs;
+    start = _now();
+    for (i = 0; i < config.iterations; i++) {
+        memcpy(argv, t->argv, sizeof(char *) * (t->argc + 1));
+        optind = 0;
+        while (getopt_long(t->argc, argv, t->shortopts, t->longopts,
+                    NULL) != -1) {
+            _eaten++;
+        }
+        _eaten += t->argc - optind;
+    }
+    _report("getopt_long", t, start, allocs, config.iterations);
+    free(argv);
+    return 0;
+}
+
+
+/* --help of the deepest command into a sink which drops everything */
+static int
+_help(struct tree *t, earg_state_t state) {
+    int i;
+    int argc;
+    double start;
+    double elapsed;
+    size_t allocs;
+    unsigned int iterations = config.iterations / 10 + 1;
+    const char **argv = malloc(sizeof(char *) * (t->pathlen + 2));
+    struct earg_sink out = {.write = _discard};
+
+    if (argv == NULL) {
+        return -1;
+    }
+
+    for (argc = 0; argc < t->pathlen; argc++) {
+        argv[argc] = t->argv[argc];
+    }
+    argv[argc++] = "--help";
+    argv[argc] = NULL;
+
+    earg_state_sinks(state, &out, NULL);
+    if (earg_parse_r(&t->root, state, argc, argv, NULL) != EARG_OK_EXIT) {
+        free(argv);
+        return -1;
+    }
+
+    allocs = _allocs;
+    start = _now();
+    for (i = 0; i < iterations; i++) {
+        earg_parse_r(&t->root, state, argc, argv, NULL);
+    }
+    elapsed = _now() - start;
+    printf("%-16s %12.0f %10s %14.2f\n", "help", iterations * 1e9 / elapsed,
+            "-",
+#ifdef BENCH_WRAP_MALLOC
+            (double)(_allocs - allocs) / iterations
+#else
+            -1.0
+#endif
+            );
+    free(argv);
+    return 0;
+}
+
+
+/* earg_compile() and earg_plan_dispose() of the whole tree */
+static int
+_compile(struct tree *t) {
+    int i;
+    double start;
+    double elapsed;
+    size_t allocs;
+    unsigned int iterations = config.iterations / 100 + 1;
+    struct earg root = t->root;
+
+    root.state = NULL;
+    root.plan = NULL;
+    allocs = _allocs;
+    start = _now();
+    for (i = 0; i < iterations; i++) {
+        if (earg_compile(&root)) {
+            return -1;
+        }
+        earg_plan_dispose(&root);
+    }
+    elapsed = _now() - start;
+    printf("%-16s %12.0f %10s %14.2f\n", "compile",
+            iterations * 1e9 / elapsed, "-",
+#ifdef BENCH_WRAP_MALLOC
+            (double)(_allocs - allocs) / iterations
+#else
+            -1.0
+#endif
+            );
+    return 0;
+}
+
+
+int
+main(int argc, const char **argv) {
+    int ret = EXIT_FAILURE;
+    struct tree tree;
+    struct earg_footprint footprint;
+    earg_state_t state = NULL;
+    enum earg_status status;
+
+    status = earg_parse(&_cli, argc, argv, NULL);
+    earg_dispose(&_cli);
+    if (status == EARG_OK_EXIT) {
+        return EXIT_SUCCESS;
+    }
+
+    if (status != EARG_OK) {
+        return EXIT_FAILURE;
+    }
+
+    if ((config.depth == 0) || (config.siblings == 0) ||
+            (config.argc == 0) || (config.iterations == 0)) {
+        fprintf(stderr, "depth, siblings, argc and iterations must be "
+                "positive\n");
+        return EXIT_FAILURE;
+    }
+
+    if (_tree_build(&tree)) {
+        goto terminate;
+    }
+
+    if (earg_footprint(&tree.root, &footprint)) {
+        fprintf(stderr, "the tree needs -DCONFIG_EARG_OPTIONS_MAX=%zu "
+                "-DCONFIG_EARG_CMDSTACK_MAX=%zu\n", footprint.options,
+                footprint.depth);
+        goto terminate;
+    }
+
+    if (earg_compile(&tree.root)) {
+        fprintf(stderr, "earg_compile() failed, see above\n");
+        goto terminate;
+    }
+
+    printf("%zu commands, %u options each, depth: %u, siblings: %u, "
+            "argc: %d, iterations: %u\n", tree.commandscount + 1,
+            config.options, config.depth, config.siblings, tree.argc,
+            config.iterations);
+    printf("plan: %zu bytes, state: %zu bytes\n", footprint.plan,
+            footprint.state);
+    printf("%-16s %12s %10s %14s\n", "scenario", "calls/s", "ns/token",
+            "allocs/call");
+
+    if (_earg_parse(&tree)) {
+        goto failed;
+    }
+
+    state = malloc(earg_state_size());
+    if ((state == NULL) || (earg_state_init(state, earg_state_size()) ==
+                NULL)) {
+        goto terminate;
+    }
+
+    if (_earg_parse_r(&tree, state) || _earg_parse_line(&tree, state) ||
+            _getopt_long(&tree) || _help(&tree, state) ||
+            _compile(&tree)) {
+        goto failed;
+    }
+
+    ret = EXIT_SUCCESS;
+    goto terminate;
+
+failed:
+    fprintf(stderr, "parse failed, see above\n");
+
+terminate:
+    free(state);
+    _tree_dispose(&tree);
+    return ret;
+}
@@ -0,0 +1,420 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+
+#include "toolbox.h"
+#include "allocator.h"
+#include "hash.h"
+#include "binding.h"
+
+
+#define MAXCHOICES 255
+#define TARGET(i, t) \
+    ((t *)((char *)(i)->command->userptr + (i)->option->offset))
+
+
+/* Mantissas below 2^24 and the powers of ten up to 1e10 are exact in
+ * float. */
+#define FLOAT_EXACTMANTISSA (1UL << 24)
+static const float _pow10[] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f,
+};
+#define FLOAT_EXACTFRAC ((sizeof(_pow10) / sizeof(_pow10[0])) - 1)
+
+
+/* Decimal or 0x prefixed hexadecimal, without the strtol overhead of
+ * locale, whitespace and errno handling. */
+static int
+_uint_parse(const char **value, unsigned long long *out) {
+    const char *s = *value;
+    unsigned long long v = 0;
+    unsigned int base = 10;
+    unsigned int d;
+
+    if ((s[0] == '0') && ((s[1] == 'x') || (s[1] == 'X')) && s[2]) {
+        base = 16;
+        s += 2;
+    }
+
+    if (*s == 0) {
+        return -1;
+    }
+
+    for (;; s++) {
+        if (ISDIGIT(*s)) {
+            d = *s - '0';
+        }
+        else if ((base == 16) && BETWEEN(*s | 0x20, 'a', 'f')) {
+            d = (*s | 0x20) - 'a' + 10;
+        }
+        else {
+            break;
+        }
+
+        if (v > ((ULLONG_MAX - d) / base)) {
+            return -1;
+        }
+        v = v * base + d;
+    }
+
+    if (s == *value) {
+        return -1;
+    }
+
+    *value = s;
+    *out = v;
+    return 0;
+}
+
+
+static int
+_int_parse(const char *value, long long min, long long max,
+        long long *out) {
+    unsigned long long v;
+    bool negative = false;
+
+    if ((*value == '-') || (*value == '+')) {
+        negative = *value == '-';
+        value++;
+    }
+
+    if (_uint_parse(&value, &v) || *value) {
+        return -1;
+    }
+
+    if (negative) {
+        if (v > ((unsigned long long)-(min + 1)) + 1) {
+            return -1;
+        }
+        *out = -(long long)(v - 1) - 1;
+        return 0;
+    }
+
+    if (v > (unsigned long long)max) {
+        return -1;
+    }
+
+    *out = v;
+    return 0;
+}
+
+
+/* Plain decimals whose digits and fraction length fit the exact float
+ * values above are a single division of two exact floats, rounded once
+ * like strtof() does. Anything else goes through strtof(). */
+static int
+_float_parse(const char *value, float *out) {
+    const char *s = value;
+    unsigned long long m = 0;
+    int digits = 0;
+    int frac = -1;
+    bool negative = false;
+    float f;
+    char *end;
+
+    if ((*s == '-') || (*s == '+')) {
+        negative = *s == '-';
+        s++;
+    }
+
+    for (; *s; s++) {
+        if (ISDIGIT(*s)) {
+            m = m * 10 + (*s - '0');
+            digits++;
+            if (frac >= 0) {
+                frac++;
+            }
+        }
+        else if ((*s == '.') && (frac < 0)) {
+            frac = 0;
+        }
+        else {
+            break;
+        }
+    }
+
+    /* m doesn't wrap up to 19 digits */
+    if ((*s == 0) && digits && (digits <= 19) &&
+            (m < FLOAT_EXACTMANTISSA) && (frac <= (int)FLOAT_EXACTFRAC)) {
+        *out = (float)m / _pow10[frac > 0? frac: 0];
+        if (negative) {
+            *out = -*out;
+        }
+        return 0;
+    }
+
+    f = strtof(value, &end);
+    if ((end == value) || *end) {
+        return -1;
+    }
+
+    *out = f;
+    return 0;
+}
+
+
+static int
+_size_parse(const char *value, size_t *out) {
+    unsigned long long v;
+    unsigned int shift = 0;
+
+    if (_uint_parse(&value, &v)) {
+        return -1;
+    }
+
+    switch (*value) {
+        case 0:
+            break;
+        case 'k':
+        case 'K':
+            shift = 10;
+            break;
+        case 'm':
+        case 'M':
+            shift = 20;
+            break;
+        case 'g':
+        case 'G':
+            shift = 30;
+            break;
+        default:
+            return -1;
+    }
+
+    if (shift && value[1]) {
+        return -1;
+    }
+
+    if ((v > (SIZE_MAX >> shift))) {
+        return -1;
+    }
+
+    *out = (size_t)(v << shift);
+    return 0;
+}
+
+
+/* 1|0, true|false, yes|no and on|off, a missing value is true */
+int
+binding_bool(const char *value, bool *out) {
+    if (value == NULL) {
+        *out = true;
+        return 0;
+    }
+
+    if (STREQ(value, "1") || STREQ(value, "true") || STREQ(value, "yes") ||
+            STREQ(value, "on")) {
+        *out = true;
+        return 0;
+    }
+
+    if (STREQ(value, "0") || STREQ(value, "false") || STREQ(value, "no") ||
+            STREQ(value, "off")) {
+        *out = false;
+        return 0;
+    }
+
+    return -1;
+}
+
+
+static int
+_choice_find(const struct optioninfo *info, const char *value) {
+    const struct choiceindex *index = info->choices;
+    const char * const *choices = info->option->choices;
+    unsigned int h;
+    unsigned char slot;
+
+    h = hash_fnv1a(index->seed, value, strlen(value)) & index->mask;
+    while ((slot = index->slots[h])) {
+        if (STREQ(value, choices[slot - 1])) {
+            return slot - 1;
+        }
+        h = (h + 1) & index->mask;
+    }
+
+    return -1;
+}
+
+
+/* slots of the choice index, keeps the load factor at most 50% */
+static unsigned int
+_slots(int count) {
+    unsigned int size = 2;
+
+    while (size < (count * 2)) {
+        size <<= 1;
+    }
+
+    return size;
+}
+
+
+/* heap bytes binding_compile() allocates for the option */
+size_t
+binding_footprint(const struct earg_option *opt) {
+    int count = 0;
+
+    if (opt->type != EARG_TYPE_ENUM) {
+        return 0;
+    }
+
+    while (opt->choices && opt->choices[count]) {
+        count++;
+    }
+
+    if ((count == 0) || (count > MAXCHOICES)) {
+        return 0;
+    }
+
+    return sizeof(struct choiceindex) + _slots(count) + count;
+}
+
+
+int
+binding_compile(struct optioninfo *info, const struct earg_allocator *a) {
+    const struct earg_option *opt = info->option;
+    struct choiceindex *index;
+    unsigned int size;
+    unsigned int h;
+    int count = 0;
+    int j;
+    unsigned char *sorted;
+
+    if (opt->type == EARG_TYPE_NONE) {
+        return 0;
+    }
+
+    if (info->command->userptr == NULL) {
+        PERR("typed option without userptr -- '--%s'\n", opt->name);
+        return -1;
+    }
+
+    if (opt->type != EARG_TYPE_ENUM) {
+        return 0;
+    }
+
+    while (opt->choices && opt->choices[count]) {
+        count++;
+    }
+
+    if ((count == 0) || (count > MAXCHOICES)) {
+        PERR("invalid choices for option -- '--%s'\n", opt->name);
+        return -1;
+    }
+    size = _slots(count);
+
+    /* the sorted list follows the slots */
+    index = allocator_calloc(a, 1, sizeof(struct choiceindex) + size +
+            count);
+    if (index == NULL) {
+        return -1;
+    }
+    index->mask = size - 1;
+    index->seed = HASH_FNV1A_BASIS;
+    index->count = count;
+    sorted = index->slots + size;
+    index->sorted = sorted;
+    info->choices = index;
+
+    for (count = 0; opt->choices[count]; count++) {
+        if (_choice_find(info, opt->choices[count]) != -1) {
+            PERR("choice duplicated -- '%s'\n", opt->choices[count]);
+            return -1;
+        }
+
+        h = hash_fnv1a(index->seed, opt->choices[count],
+                strlen(opt->choices[count])) & index->mask;
+        while (index->slots[h]) {
+            h = (h + 1) & index->mask;
+        }
+        index->slots[h] = count + 1;
+
+        for (j = count; (j > 0) && (strcmp(opt->choices[count],
+                        opt->choices[sorted[j - 1]]) < 0); j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = count;
+    }
+
+    return 0;
+}
+
+
+void
+binding_dispose(struct optioninfo *info, const struct earg_allocator *a) {
+    if (info->choices == NULL) {
+        return;
+    }
+
+    allocator_free(a, (struct choiceindex *)info->choices);
+    info->choices = NULL;
+}
+
+
+int
+binding_store(const struct optioninfo *info, const char *value) {
+    long long i;
+    int choice;
+
+    /* only the bool flags may go without a value */
+    if ((value == NULL) && (info->option->type != EARG_TYPE_BOOL)) {
+        return -1;
+    }
+
+    switch (info->option->type) {
+        case EARG_TYPE_INT:
+            if (_int_parse(value, INT_MIN, INT_MAX, &i)) {
+                return -1;
+            }
+            *TARGET(info, int) = (int)i;
+            return 0;
+
+        case EARG_TYPE_UINT:
+            if ((*value == '-') || _int_parse(value, 0, UINT_MAX, &i)) {
+                return -1;
+            }
+            *TARGET(info, unsigned int) = (unsigned int)i;
+            return 0;
+
+        case EARG_TYPE_FLOAT:
+            return _float_parse(value, TARGET(info, float));
+
+        case EARG_TYPE_BOOL:
+            return binding_bool(value, TARGET(info, bool));
+
+        case EARG_TYPE_SIZE:
+            return _size_parse(value, TARGET(info, size_t));
+
+        case EARG_TYPE_ENUM:
+            choice = _choice_find(info, value);
+            if (choice == -1) {
+                return -1;
+            }
+            *TARGET(info, int) = choice;
+            return 0;
+
+        default:
+            return -1;
+    }
+}
@@ -0,0 +1,59 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef BINDING_H_
+#define BINDING_H_
+
+
+#include "earg.h"
+#include "optiondb.h"
+
+
+/* Open addressing table over the choices of an EARG_TYPE_ENUM option,
+ * slots store the choice index + 1, zero means empty. sorted holds the
+ * choice indexes ordered by value. */
+struct choiceindex {
+    unsigned int mask;
+    unsigned int seed;
+    unsigned char count;
+    const unsigned char *sorted;
+    unsigned char slots[];
+};
+
+
+int
+binding_compile(struct optioninfo *info, const struct earg_allocator *a);
+
+
+void
+binding_dispose(struct optioninfo *info, const struct earg_allocator *a);
+
+
+size_t
+binding_footprint(const struct earg_option *opt);
+
+
+int
+binding_bool(const char *value, bool *out);
+
+
+int
+binding_store(const struct optioninfo *info, const char *value);
+
+
+#endif  // BINDING_H_
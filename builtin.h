@@ -22,6 +22,18 @@
 #include "earg.h"
 
 
+/* builtin dispatch, frozen into the optioninfo by the plan */
+enum builtin {
+    BUILTIN_NONE = 0,
+    BUILTIN_VERSION,
+    BUILTIN_HELP,
+    BUILTIN_USAGE,
+    BUILTIN_VERBOSITY,
+    BUILTIN_VERBOSER,
+    BUILTIN_QUIETER,
+};
+
+
 extern const struct earg_option opt_verbosity;
 extern const struct earg_option opt_verboseflag;
 extern const struct earg_option opt_quietflag;
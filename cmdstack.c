@@ -18,6 +18,7 @@
  */
 #include <stdio.h>
 
+#include "sink.h"
 #include "cmdstack.h"
 
 
@@ -53,7 +54,7 @@ cmdstack_push(struct cmdstack *s, const char *name,
 
 
 int
-cmdstack_print(FILE *file, struct cmdstack *s) {
+cmdstack_print(struct earg_sink *sink, struct cmdstack *s) {
     int i;
     int bytes = 0;
     int status;
@@ -63,7 +64,7 @@ cmdstack_print(FILE *file, struct cmdstack *s) {
     }
 
     for (i = 0; i < s->len; i++) {
-        status = fprintf(file, "%s%s", i? " ": "", s->names[i]);
+        status = sink_printf(sink, "%s%s", i? " ": "", s->names[i]);
         if (status == -1) {
             return -1;
         }
@@ -20,6 +20,9 @@
 #define CMDSTACK_H_
 
 
+#include "earg.h"
+
+
 struct cmdstack {
     const char *names[CONFIG_EARG_CMDSTACK_MAX];
     const struct earg_command *commands[CONFIG_EARG_CMDSTACK_MAX];
@@ -41,7 +44,7 @@ cmdstack_last(struct cmdstack *s);
 
 
 int
-cmdstack_print(FILE *file, struct cmdstack *s);
+cmdstack_print(struct earg_sink *sink, struct cmdstack *s);
 
 
 #endif  // CMDSTACK_H_
@@ -0,0 +1,341 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "toolbox.h"
+#include "allocator.h"
+#include "binding.h"
+#include "option.h"
+#include "optiondb.h"
+#include "plan.h"
+#include "prefix.h"
+#include "splitter.h"
+#include "tokenizer.h"
+
+
+/* Appended to the line, so the last word is always the one under the
+ * cursor, even if it's empty or ends with an escape. */
+#define SENTINEL '_'
+
+
+struct completion {
+    struct earg_candidate *candidates;
+    size_t size;
+    size_t count;
+};
+
+
+static void
+_add(struct completion *comp, enum earg_candidatetype type,
+        const char *name) {
+    struct earg_candidate *candidate;
+
+    if (comp->count < comp->size) {
+        candidate = comp->candidates + comp->count;
+        candidate->type = type;
+        candidate->name = name;
+    }
+    comp->count++;
+}
+
+
+static const char *
+_choicename(const void *table, int i) {
+    const struct optioninfo *info = table;
+
+    return info->option->choices[info->choices->sorted[i]];
+}
+
+
+static void
+_choices(struct completion *comp, const struct optioninfo *info,
+        const char *prefix) {
+    int i;
+    int first;
+    int count;
+
+    if (info->choices == NULL) {
+        return;
+    }
+
+    count = prefix_search(info, info->choices->count, _choicename, prefix,
+            strlen(prefix), &first);
+    for (i = first; i < (first + count); i++) {
+        _add(comp, EARG_CANDIDATE_CHOICE, _choicename(info, i));
+    }
+}
+
+
+static void
+_options(struct completion *comp, const struct optiondb *db,
+        const char *prefix) {
+    int i;
+    int first;
+    int count;
+    const struct optiondb *scope;
+    const struct optioninfo *info;
+
+    for (scope = db; scope; scope = scope->parent) {
+        count = optiondb_prefixsearch(scope, prefix, strlen(prefix), &first);
+        for (i = first; i < (first + count); i++) {
+            info = scope->repo + scope->sorted[i];
+            if ((scope == db) || optiondb_visible(db, info)) {
+                _add(comp, EARG_CANDIDATE_OPTION, info->option->name);
+            }
+        }
+    }
+}
+
+
+static void
+_commands(struct completion *comp, const struct plannode *node,
+        const char *prefix) {
+    int i;
+    int first;
+    int count;
+
+    count = plan_prefixsearch(node, prefix, &first);
+    for (i = first; i < (first + count); i++) {
+        if (plan_prefixlisted(node, first, count, i)) {
+            _add(comp, EARG_CANDIDATE_COMMAND, node->dispatch[i].name);
+        }
+    }
+}
+
+
+/* -abc, the value of the first option which takes one is the rest,
+ * returns its offset inside the word, or zero */
+static size_t
+_shortoptions(struct completion *comp, const struct optiondb *db,
+        const char *word) {
+    int i;
+    const struct optioninfo *info;
+
+    for (i = 1; word[i]; i++) {
+        info = optiondb_findbykey(db, word[i]);
+        if (info == NULL) {
+            return 0;
+        }
+
+        if (EARG_OPTION_ARGNEEDED(info->option)) {
+            if (word[i + 1] == 0) {
+                return 0;
+            }
+
+            _choices(comp, info, word + i + 1);
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/* Position in the line of the byte the unquoted word's byte at offset is
+ * read from, or the cursor if the word is shorter. The word is split
+ * again, a byte at a time, into buff. */
+static size_t
+_source(const char *line, size_t wordstart, size_t cursor, size_t offset,
+        char *buff) {
+    struct splitter s;
+    char *word;
+    size_t r;
+
+    splitter_init(&s, buff, 0, cursor - wordstart + 1, false);
+    for (r = wordstart; r < cursor; r++) {
+        splitter_feed(&s, line + r, 1);
+        splitter_next(&s, &word);
+        if (s.w > offset) {
+            return r;
+        }
+    }
+
+    return cursor;
+}
+
+
+ssize_t
+earg_complete(const struct earg *c, const char *line, size_t cursor,
+        size_t *start, struct earg_candidate *candidates, size_t count) {
+    struct completion comp = {candidates, count, 0};
+    struct splitter splitter;
+    struct tokenizer t;
+    struct token tok;
+    enum splitter_status status;
+    enum tokenizer_status tokstatus;
+    const struct plannode *node;
+    const struct plannode *subnode;
+    const struct optioninfo *info;
+    const struct optioninfo *pending = NULL;
+    bool executable = true;
+    char scratch[CONFIG_EARG_COMPLETE_BUFFSIZE];
+    char *buff = scratch;
+    char *prefix;
+    char *word = NULL;
+    char *eq;
+    size_t wordstart = 0;
+    size_t offset = 0;
+    size_t r;
+    int matches;
+
+    if ((c == NULL) || (c->plan == NULL) || (line == NULL) ||
+            (start == NULL)) {
+        return -1;
+    }
+    *start = cursor;
+
+    /* the current word, and the line before it for the tokenizer, on the
+     * stack unless the line is too long */
+    if ((cursor * 2 + 3) > sizeof(scratch)) {
+        buff = allocator_malloc(c->allocator, cursor * 2 + 3);
+        if (buff == NULL) {
+            return -1;
+        }
+    }
+    memcpy(buff, line, cursor);
+    buff[cursor] = SENTINEL;
+    splitter_init(&splitter, buff, cursor + 1, cursor + 2, true);
+
+    for (;;) {
+        r = splitter.r;
+        status = splitter_next(&splitter, &prefix);
+        if (status == SPLITTER_END) {
+            break;
+        }
+
+        /* the word under the cursor is inside an open quote */
+        if (status == SPLITTER_ERROR) {
+            buff[splitter.w] = 0;
+            word = buff + splitter.start;
+            wordstart = r;
+            break;
+        }
+
+        word = prefix;
+        wordstart = r;
+    }
+
+    while ((wordstart < cursor) && ISBLANK(line[wordstart])) {
+        wordstart++;
+    }
+    word[strlen(word) - 1] = 0;
+    *start = wordstart;
+
+    /* resolve the sub-command and the pending option, like earg_parse() */
+    node = c->plan->nodes;
+    memcpy(buff + cursor + 2, line, wordstart);
+    tokenizer_initline(&t, buff + cursor + 2, wordstart, wordstart + 1, true,
+            &node->optiondb);
+    t.abbrev = HASFLAG(c, EARG_ABBREV);
+
+    for (;;) {
+        tokstatus = tokenizer_next(&t, &tok);
+        if ((tokstatus == EARG_TOK_UNKNOWN) ||
+                (tokstatus == EARG_TOK_AMBIGUOUS)) {
+            pending = NULL;
+            continue;
+        }
+
+        if (tokstatus <= EARG_TOK_END) {
+            break;
+        }
+
+        if (executable) {
+            executable = false;
+            continue;
+        }
+
+        if (pending) {
+            pending = NULL;
+            continue;
+        }
+
+        if (tok.optioninfo == NULL) {
+            subnode = plan_findchild(node, tok.text);
+            if ((subnode == NULL) && t.abbrev) {
+                subnode = plan_findchildbyprefix(node, tok.text, &matches);
+            }
+
+            if (subnode) {
+                node = subnode;
+                tokenizer_optiondb(&t, &node->optiondb);
+            }
+            continue;
+        }
+
+        if (EARG_OPTION_ARGNEEDED(tok.optioninfo->option) &&
+                (tok.text == NULL)) {
+            pending = tok.optioninfo;
+        }
+    }
+
+    if (executable) {
+        goto terminate;
+    }
+
+    if (pending) {
+        _choices(&comp, pending, word);
+        goto terminate;
+    }
+
+    if (t.dashdash || (word[0] != '-')) {
+        _commands(&comp, node, word);
+        goto terminate;
+    }
+
+    if (word[1] == 0) {
+        _options(&comp, &node->optiondb, "");
+        goto terminate;
+    }
+
+    if (word[1] != '-') {
+        offset = _shortoptions(&comp, &node->optiondb, word);
+        goto terminate;
+    }
+
+    /* --name=value */
+    eq = strchr(word, '=');
+    if (eq == NULL) {
+        _options(&comp, &node->optiondb, word + 2);
+        goto terminate;
+    }
+
+    info = optiondb_findbyname(&node->optiondb, word + 2, eq - word - 2);
+    if ((info == NULL) && t.abbrev) {
+        info = optiondb_findbyprefix(&node->optiondb, word + 2,
+                eq - word - 2, &matches);
+    }
+
+    if (info) {
+        offset = eq - word + 1;
+        _choices(&comp, info, eq + 1);
+    }
+
+terminate:
+    /* the value inside the word, the tokenizer's copy is not used anymore */
+    if (offset) {
+        *start = _source(line, wordstart, cursor, offset, buff + cursor + 2);
+    }
+
+    if (buff != scratch) {
+        allocator_free(c->allocator, buff);
+    }
+    return comp.count;
+}
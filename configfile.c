@@ -0,0 +1,160 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <ctype.h>
+#include <errno.h>
+#include <string.h>
+
+#include "allocator.h"
+#include "configfile.h"
+
+
+/* Strips the surrounding whitespace in place */
+static char *
+_strip(char *start, char *end) {
+    while ((start < end) && isspace((unsigned char)*start)) {
+        start++;
+    }
+
+    while ((end > start) && isspace((unsigned char)end[-1])) {
+        end--;
+    }
+
+    *end = 0;
+    return start;
+}
+
+
+void
+configfile_init(struct configfile *f, char *buff, size_t len) {
+    f->cursor = buff;
+    f->end = buff + len;
+    f->line = 0;
+}
+
+
+enum configfile_status
+configfile_next(struct configfile *f, char **key, char **value) {
+    char *line;
+    char *eol;
+    char *eq;
+    size_t len;
+
+    while (f->cursor < f->end) {
+        eol = memchr(f->cursor, '\n', f->end - f->cursor);
+        if (eol == NULL) {
+            eol = f->end;
+        }
+
+        line = _strip(f->cursor, eol);
+        len = strlen(line);
+        f->cursor = eol + 1;
+        f->line++;
+
+        /* blanks and comments */
+        if ((len == 0) || (line[0] == '#') || (line[0] == ';')) {
+            continue;
+        }
+
+        if (line[0] == '[') {
+            if (line[len - 1] != ']') {
+                return CONFIGFILE_ERROR;
+            }
+
+            *key = _strip(line + 1, line + len - 1);
+            return **key? CONFIGFILE_SECTION: CONFIGFILE_ERROR;
+        }
+
+        eq = strchr(line, '=');
+        if (eq == NULL) {
+            *key = line;
+            *value = NULL;
+            return CONFIGFILE_ENTRY;
+        }
+
+        *key = _strip(line, eq);
+        if (**key == 0) {
+            return CONFIGFILE_ERROR;
+        }
+
+        *value = _strip(eq + 1, line + len);
+        len = strlen(*value);
+        if ((len > 1) && ((*value)[0] == '"') && ((*value)[len - 1] == '"')) {
+            (*value)[len - 1] = 0;
+            (*value)++;
+        }
+
+        return CONFIGFILE_ENTRY;
+    }
+
+    return CONFIGFILE_END;
+}
+
+
+void
+configfile_load(struct configtable *t, const char *path,
+        const struct earg_allocator *a) {
+    struct configfile reader;
+    struct configentry *entry;
+    const char *eol;
+    size_t lines = 1;
+    char *key;
+    char *value;
+
+    memset(t, 0, sizeof(struct configtable));
+    t->file = responsefile_open(path, a);
+    if (t->file == NULL) {
+        t->error = (errno == ENOENT)? 0: errno;
+        return;
+    }
+
+    /* at most an entry per line */
+    eol = t->file->buff;
+    while ((eol = memchr(eol, '\n', t->file->buff + t->file->len - eol))) {
+        eol++;
+        lines++;
+    }
+
+    t->entries = allocator_malloc(a, sizeof(struct configentry) * lines);
+    if (t->entries == NULL) {
+        t->error = ENOMEM;
+        return;
+    }
+
+    configfile_init(&reader, t->file->buff, t->file->len);
+    while ((t->status = configfile_next(&reader, &key, &value)) >
+            CONFIGFILE_END) {
+        entry = t->entries + t->count++;
+        entry->key = key;
+        entry->value = (t->status == CONFIGFILE_ENTRY)? value: NULL;
+        entry->line = reader.line;
+        entry->section = t->status == CONFIGFILE_SECTION;
+        entry->node = NULL;
+    }
+    t->line = reader.line;
+}
+
+
+void
+configfile_unload(struct configtable *t, const struct earg_allocator *a) {
+    allocator_free(a, t->entries);
+    if (t->file) {
+        responsefile_close(t->file, a);
+    }
+    memset(t, 0, sizeof(struct configtable));
+}
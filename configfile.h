@@ -0,0 +1,95 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef CONFIGFILE_H_
+#define CONFIGFILE_H_
+
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "earg.h"
+#include "responsefile.h"
+
+
+enum configfile_status {
+    CONFIGFILE_ERROR = -1,
+    CONFIGFILE_END = 0,
+    CONFIGFILE_SECTION = 1,
+    CONFIGFILE_ENTRY = 2,
+};
+
+
+/* Streaming reader of key=value files with [sub.command] sections, lines
+ * are read one at a time and terminated in place. The byte after the
+ * buffer must be writable. */
+struct configfile {
+    char *cursor;
+    char *end;
+    int line;
+};
+
+
+void
+configfile_init(struct configfile *f, char *buff, size_t len);
+
+
+/* The next section, its name is returned in key, or entry. Values are
+ * stripped of the surrounding whitespace and double quotes, bare keys
+ * come with a NULL value. */
+enum configfile_status
+configfile_next(struct configfile *f, char **key, char **value);
+
+
+/* A section or an entry of a whole file, see configfile_load() */
+struct configentry {
+    const char *key;
+    const char *value;
+    int line;
+    bool section;
+
+    /* the command of the section, resolved by the caller, NULL if there
+     * is no such command */
+    const void *node;
+};
+
+
+/* Whole file read at once, the entries are shared read-only by the
+ * parses. A missing file is empty, error is the errno if it can't be
+ * read. If a line is invalid, the entries before it are kept and status
+ * is CONFIGFILE_ERROR with its line. */
+struct configtable {
+    struct responsefile *file;
+    struct configentry *entries;
+    size_t count;
+    int error;
+    enum configfile_status status;
+    int line;
+};
+
+
+void
+configfile_load(struct configtable *t, const char *path,
+        const struct earg_allocator *a);
+
+
+void
+configfile_unload(struct configtable *t, const struct earg_allocator *a);
+
+
+#endif  // CONFIGFILE_H_
@@ -0,0 +1,114 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <string.h>
+
+#include "allocator.h"
+#include "defaults.h"
+
+
+extern char **environ;
+
+
+/* The section is a dotted path of sub-commands from the root, NULL if
+ * there is no such command. */
+static const struct plannode *
+_section(const struct plannode *node, char *name) {
+    char *dot;
+
+    while (node) {
+        dot = strchr(name, '.');
+        if (dot == NULL) {
+            return plan_findchild(node, name);
+        }
+
+        /* the name is put back whole for the diagnostics, found or not */
+        *dot = 0;
+        node = plan_findchild(node, name);
+        *dot = '.';
+        name = dot + 1;
+    }
+
+    return NULL;
+}
+
+
+void
+defaults_config(struct configtable *t, const struct earg *c,
+        const struct plannode *root) {
+    int i;
+
+    configfile_load(t, c->configfile, c->allocator);
+    for (i = 0; i < t->count; i++) {
+        if (t->entries[i].section) {
+            t->entries[i].node = _section(root, (char *)t->entries[i].key);
+        }
+    }
+}
+
+
+/* Only the variables of the tree are kept, the environment is scanned
+ * once for the whole batch. */
+static int
+_environ_load(struct defaults *d, const struct earg *c) {
+    char **var;
+    size_t count = 0;
+    size_t prefixlen = strlen(c->envprefix);
+
+    for (var = environ; var && *var; var++) {
+        if (strncmp(*var, c->envprefix, prefixlen) == 0) {
+            count++;
+        }
+    }
+
+    d->environ = allocator_malloc(c->allocator, sizeof(char *) * (count + 1));
+    if (d->environ == NULL) {
+        return -1;
+    }
+
+    count = 0;
+    for (var = environ; var && *var; var++) {
+        if (strncmp(*var, c->envprefix, prefixlen) == 0) {
+            d->environ[count++] = *var;
+        }
+    }
+    d->environ[count] = NULL;
+    return 0;
+}
+
+
+int
+defaults_load(struct defaults *d, const struct earg *c) {
+    memset(d, 0, sizeof(struct defaults));
+    if (c->envprefix && _environ_load(d, c)) {
+        return -1;
+    }
+
+    if (c->configfile) {
+        defaults_config(&d->config, c, c->plan->nodes);
+    }
+
+    return 0;
+}
+
+
+void
+defaults_dispose(struct defaults *d, const struct earg *c) {
+    allocator_free(c->allocator, d->environ);
+    configfile_unload(&d->config, c->allocator);
+}
@@ -0,0 +1,55 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef DEFAULTS_H_
+#define DEFAULTS_H_
+
+
+#include "earg.h"
+#include "configfile.h"
+#include "plan.h"
+
+
+/* Environment and config file defaults of a batch, read once and shared
+ * read-only by the parses of its lines, see earg_parse_batch(). */
+struct defaults {
+    /* the variables starting with the envprefix, NULL terminated, NULL
+     * if the tree has no envprefix */
+    char **environ;
+    struct configtable config;
+};
+
+
+/* Reads the config file of the tree and resolves its sections to the
+ * commands under the root. */
+void
+defaults_config(struct configtable *t, const struct earg *c,
+        const struct plannode *root);
+
+
+/* The tree must be compiled, returns -1 if it's out of memory. A config
+ * file which can't be read is reported by each parse. */
+int
+defaults_load(struct defaults *d, const struct earg *c);
+
+
+void
+defaults_dispose(struct defaults *d, const struct earg *c);
+
+
+#endif  // DEFAULTS_H_
@@ -16,195 +16,372 @@
  *
  *  Author: Vahid Mardani <vahid.mardani@gmail.com>
  */
+#include <errno.h>
 #include <unistd.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <limits.h>
 #include <string.h>
 #include <elog.h>
 
 #include "earg.h"
 #include "state.h"
 #include "toolbox.h"
+#include "allocator.h"
 #include "builtin.h"
+#include "binding.h"
 #include "arghint.h"
-#include "command.h"
+#include "configfile.h"
+#include "defaults.h"
+#include "help.h"
 #include "option.h"
 #include "optiondb.h"
+#include "plan.h"
+#include "responsefile.h"
+#include "sink.h"
+#include "stats.h"
+#include "suggest.h"
 #include "tokenizer.h"
 
 
+/* environment variables with longer names are not options */
+#define ENVIRON_NAMEMAX 64
+
+
+/* occurance of the options eaten from the config file, they may repeat
+ * there, the command line saturates below it */
+#define OCCURANCE_CONFIG UCHAR_MAX
+
+
+extern char **environ;
+
+
+/* diagnostics go to the state's error stream */
+#define SERR(s, ...) sink_printf(&(s)->err, __VA_ARGS__)
+
 #define TRYHELP(s) \
-    PERR("Try `"); \
-    cmdstack_print(stderr, &(s)->cmdstack); \
-    PERR(" --help' or `"); \
-    cmdstack_print(stderr, &(s)->cmdstack); \
-    PERR(" --usage' for more information.\n")
+    SERR(s, "Try `"); \
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, " --help' or `"); \
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, " --usage' for more information.\n")
 
 #define REJECT_OPTION_MISSINGARGUMENT(s, o) \
-    cmdstack_print(stderr, &(s)->cmdstack); \
-    PERR(": option requires an argument -- '"); \
-    option_print(stderr, o); \
-    PERR("'\n")
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, ": option requires an argument -- '"); \
+    option_print(&(s)->err, o); \
+    SERR(s, "'\n")
 
 #define REJECT_OPTION_HASARGUMENT(s, o) \
-    cmdstack_print(stderr, &(s)->cmdstack); \
-    PERR(": no argument allowed for option -- '"); \
-    option_print(stderr, o); \
-    PERR("'\n")
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, ": no argument allowed for option -- '"); \
+    option_print(&(s)->err, o); \
+    SERR(s, "'\n")
 
 #define REJECT_OPTION_UNRECOGNIZED(s, name, len) \
-    cmdstack_print(stderr, &(s)->cmdstack); \
-    PERR(": invalid option -- '%s%.*s'\n", \
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, ": invalid option -- '%s%.*s'\n", \
         len == 1? "-": "", len, name)
 
 #define REJECT_OPTION_NOTEATEN(s, o) \
-    cmdstack_print(stderr, &(s)->cmdstack); \
-    PERR(": option not eaten -- '"); \
-    option_print(stderr, o); \
-    PERR("'\n")
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, ": option not eaten -- '"); \
+    option_print(&(s)->err, o); \
+    SERR(s, "'\n")
 
 #define REJECT_OPTION_REDUNDANT(s, o) \
-    cmdstack_print(stderr, &(s)->cmdstack); \
-    PERR(": redundant option -- '"); \
-    option_print(stderr, o); \
-    PERR("'\n")
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, ": redundant option -- '"); \
+    option_print(&(s)->err, o); \
+    SERR(s, "'\n")
+
+#define REJECT_OPTION_INVALID(s, o, v) \
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, ": invalid value '%s' for option -- '", v); \
+    option_print(&(s)->err, o); \
+    SERR(s, "'\n")
+
+#define REJECT_OPTION_AMBIGUOUS(s, name, len) \
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, ": ambiguous option -- '%.*s', possibilities:", len, name); \
+    _options_print(s, (s)->node, name + 2, len - 2); \
+    SERR(s, "\n")
+
+#define REJECT_COMMAND_AMBIGUOUS(s, name) \
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, ": ambiguous command -- '%s', possibilities:", name); \
+    _commands_print(s, (s)->node, name); \
+    SERR(s, "\n")
 
 #define REJECT_POSITIONAL_NOTEATEN(s, t) \
-    cmdstack_print(stderr, &(s)->cmdstack); \
-    PERR(": argument not eaten -- '%s'\n", t)
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, ": argument not eaten -- '%s'\n", t)
 
 #define REJECT_POSITIONAL(s, t) \
-    cmdstack_print(stderr, &(s)->cmdstack); \
-    PERR(": invalid argument -- '%s'\n", t)
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, ": invalid argument -- '%s'\n", t)
+
+#define REJECT_SYNTAX(s) \
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, ": unterminated quote or escape\n")
+
+#define REJECT_RESPONSEFILE(s, t, p) \
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    if ((t)->error) { \
+        SERR(s, ": cannot read response file -- '%s': %s\n", p, \
+                strerror((t)->error)); \
+    } \
+    else { \
+        SERR(s, ": response files are nested too deep -- '%s'\n", p); \
+    }
+
+#define REJECT_ENVIRON_INVALID(s, var, len, v) \
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, ": invalid value '%s' for environment variable -- '%.*s'\n", \
+            v, len, var)
+
+#define REJECT_CONFIG(s, p, f, msg, t) \
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, ": %s:%d: " msg " -- '%s'\n", p, (f)->line, t)
+
+#define REJECT_CONFIG_INVALID(s, p, f, k, v) \
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, ": %s:%d: invalid value '%s' for option -- '%s'\n", \
+            p, (f)->line, v, k)
+
+#define REJECT_CONFIG_SYNTAX(s, p, f) \
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, ": %s:%d: invalid line\n", p, (f)->line)
+
+#define REJECT_CONFIG_FILE(s, p, e) \
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, ": cannot read config file -- '%s': %s\n", p, strerror(e))
 
 #define REJECT_POSITIONALCOUNT(s) \
-    cmdstack_print(stderr, &(s)->cmdstack); \
-    PERR(": invalid positional arguments count\n")
+    cmdstack_print(&(s)->err, &(s)->cmdstack); \
+    SERR(s, ": invalid positional arguments count\n")
+
+
+/* Candidates of an ambiguous abbreviation */
+static void
+_options_print(struct earg_state *state, const struct plannode *node,
+        const char *prefix, int len) {
+    int i;
+    int first;
+    int count;
+    const struct optiondb *db = &node->optiondb;
+    const struct optiondb *scope;
+    const struct optioninfo *info;
+
+    for (scope = db; scope; scope = scope->parent) {
+        count = optiondb_prefixsearch(scope, prefix, len, &first);
+        for (i = first; i < (first + count); i++) {
+            info = scope->repo + scope->sorted[i];
+            if ((scope == db) || optiondb_visible(db, info)) {
+                SERR(state, " '--%s'", info->option->name);
+            }
+        }
+    }
+}
 
 
-static int
-_build_optiondb(const struct earg *c, struct optiondb *db) {
-    if (optiondb_init(db)) {
-        return -1;
+static void
+_commands_print(struct earg_state *state, const struct plannode *node,
+        const char *prefix) {
+    int i;
+    int first;
+    int count;
+
+    count = plan_prefixsearch(node, prefix, &first);
+    for (i = first; i < (first + count); i++) {
+        if (plan_prefixlisted(node, first, count, i)) {
+            SERR(state, " '%s'", node->dispatch[i].name);
+        }
     }
+}
 
-    if (c->version && optiondb_insert(db, &opt_version,
-                (struct earg_command *)c)) {
-        return -1;
+
+/* Closest long option or sub-command to a mistyped one */
+static void
+_option_suggest(struct earg_state *state, const char *name, int len) {
+    int i;
+    struct suggest s;
+    const struct optiondb *db = &state->node->optiondb;
+    const struct optiondb *scope;
+    const struct optioninfo *info;
+
+    if (suggest_init(&s, name, len)) {
+        return;
     }
 
-    if ((!HASFLAG(c, EARG_NOHELP)) && optiondb_insert(db, &opt_help,
-                (struct earg_command *)c)) {
-        return -1;
+    for (scope = db; scope; scope = scope->parent) {
+        for (i = 0; i < scope->sortedcount; i++) {
+            info = scope->repo + scope->sorted[i];
+            if ((scope == db) || info->inherited) {
+                suggest_try(&s, info->option->name);
+            }
+        }
     }
 
-    if ((!HASFLAG(c, EARG_NOUSAGE)) && optiondb_insert(db, &opt_usage,
-                (struct earg_command *)c)) {
-        return -1;
+    if (s.best) {
+        SERR(state, "Did you mean '--%s'?\n", s.best);
     }
+}
 
-    if (!HASFLAG(c, EARG_NOELOG)) {
-        if (optiondb_insert(db, &opt_verbosity, (struct earg_command *)c)) {
-            return -1;
-        }
-        if (optiondb_insert(db, &opt_verboseflag, (struct earg_command *)c)) {
-            return -1;
-        }
-        if (optiondb_insert(db, &opt_quietflag, (struct earg_command *)c)) {
-            return -1;
-        }
+
+static void
+_command_suggest(struct earg_state *state, const char *name) {
+    int i;
+    struct suggest s;
+    const struct plannode *node = state->node;
+
+    if ((node->dispatchcount == 0) ||
+            suggest_init(&s, name, strlen(name))) {
+        return;
     }
 
-    return 0;
+    for (i = 0; i < node->dispatchcount; i++) {
+        suggest_try(&s, node->dispatch[i].name);
+    }
+
+    if (s.best) {
+        SERR(state, "Did you mean '%s'?\n", s.best);
+    }
 }
 
 
-void
-_elogquieter() {
-    if (elog_verbosity > ELOG_SILENT) {
-        elog_verbosity--;
+/* Verbosity changes are collected in the state and applied at the end of
+ * a successful parse, see _verbosity_apply(). */
+static int
+_verbosity(struct earg_state *state) {
+    if (state->verbosity == ELOG_UNKNOWN) {
+        return __atomic_load_n(&elog_verbosity, __ATOMIC_RELAXED);
     }
+
+    return state->verbosity;
 }
 
 
-void
-_elogverboser() {
-    if (elog_verbosity < ELOG_DEBUG) {
-        elog_verbosity++;
+static void
+_elogquieter(struct earg_state *state) {
+    int verbosity = _verbosity(state);
+
+    if (verbosity > ELOG_SILENT) {
+        verbosity--;
     }
+    state->verbosity = verbosity;
 }
 
-void
-_elogverbosity(const char *value) {
+
+static void
+_elogverboser(struct earg_state *state) {
+    int verbosity = _verbosity(state);
+
+    if (verbosity < ELOG_DEBUG) {
+        verbosity++;
+    }
+    state->verbosity = verbosity;
+}
+
+
+static void
+_elogverbosity(struct earg_state *state, const char *value) {
     int valuelen = value? strlen(value): 0;
 
     if (valuelen == 0) {
-        elog_verbosity = ELOG_INFO;
+        state->verbosity = ELOG_INFO;
         return;
     }
 
     if (valuelen == 1) {
         if (ISDIGIT(value[0])) {
             /* -v0 ... -v5 */
-            elog_verbosity = atoi(value);
-            if (!BETWEEN(elog_verbosity, ELOG_SILENT, ELOG_DEBUG)) {
-                elog_verbosity = ELOG_INFO;
+            state->verbosity = atoi(value);
+            if (!BETWEEN(state->verbosity, ELOG_SILENT, ELOG_DEBUG)) {
+                state->verbosity = ELOG_INFO;
                 return;
             }
             return;
         }
     }
 
-    elog_verbosity = elog_verbosity_from_string(value);
-    if (elog_verbosity == ELOG_UNKNOWN) {
-        elog_verbosity = ELOG_INFO;
+    state->verbosity = elog_verbosity_from_string(value);
+    if (state->verbosity == ELOG_UNKNOWN) {
+        state->verbosity = ELOG_INFO;
         return;
     }
 }
 
 
+static void
+_verbosity_apply(struct earg_state *state) {
+    if (state->verbosity == ELOG_UNKNOWN) {
+        return;
+    }
+
+    __atomic_store_n(&elog_verbosity, state->verbosity, __ATOMIC_RELAXED);
+}
+
+
 static enum earg_eatstatus
-_eat(const struct earg *c, const struct earg_command *command,
-        const struct earg_option *opt, const char *value) {
+_eat(const struct earg *c, struct earg_state *state,
+        const struct earg_command *command, const struct optioninfo *info,
+        const char *value) {
+#ifdef CONFIG_EARG_STATS
+    enum earg_eatstatus status;
+    uint64_t start;
+#endif
+
     /* Try to solve it internaly */
-    if (c->version && (opt == &opt_version)) {
-        POUT("%s\n", c->version);
-        return EARG_EAT_OK_EXIT;
-    }
+    switch (info? info->builtin: BUILTIN_NONE) {
+        case BUILTIN_VERSION:
+            sink_printf(&state->out, "%s\n", c->version);
+            return EARG_EAT_OK_EXIT;
 
-    if ((!HASFLAG(c, EARG_NOHELP)) && (opt == &opt_help)) {
-        earg_help_print(stdout, c);
-        return EARG_EAT_OK_EXIT;
-    }
+        case BUILTIN_HELP:
+            help_print(&state->out, c, state);
+            return EARG_EAT_OK_EXIT;
 
-    if ((!HASFLAG(c, EARG_NOUSAGE)) && (opt == &opt_usage)) {
-        earg_usage_print(stdout, c);
-        return EARG_EAT_OK_EXIT;
-    }
+        case BUILTIN_USAGE:
+            help_usage_print(&state->out, c, state);
+            return EARG_EAT_OK_EXIT;
 
-    if (!HASFLAG(c, EARG_NOELOG)) {
-        if (opt == &opt_verbosity) {
-            _elogverbosity(value);
+        case BUILTIN_VERBOSITY:
+            _elogverbosity(state, value);
             return EARG_EAT_OK;
-        }
 
-        if (opt == &opt_verboseflag) {
-            _elogverboser();
+        case BUILTIN_VERBOSER:
+            _elogverboser(state);
             return EARG_EAT_OK;
-        }
 
-        if (opt == &opt_quietflag) {
-            _elogquieter();
+        case BUILTIN_QUIETER:
+            _elogquieter(state);
             return EARG_EAT_OK;
+    }
+
+    /* typed options are stored directly */
+    if (info && info->option->type) {
+        if (binding_store(info, value)) {
+            return EARG_EAT_INVALID;
         }
+        return EARG_EAT_OK;
     }
 
-    if (command->eat) {
-        return command->eat(opt, value, command->userptr);
+    if (command->eat == NULL) {
+        return EARG_EAT_NOTEATEN;
     }
 
-    return EARG_EAT_NOTEATEN;
+#ifdef CONFIG_EARG_STATS
+    start = stats_now();
+    status = command->eat(info? info->option: NULL, value, command->userptr);
+    state->stats.eatns += stats_now() - start;
+    state->stats.eats++;
+    return status;
+#else
+    return command->eat(info? info->option: NULL, value, command->userptr);
+#endif
 }
 
 
@@ -212,79 +389,215 @@ _eat(const struct earg *c, const struct earg_command *command,
 #define NEXT(t, tok) tokenizer_next(t, tok)
 
 
+int
+earg_compile(struct earg *c) {
+    if (c == NULL) {
+        return -1;
+    }
+
+    if (c->plan) {
+        return 0;
+    }
+
+    return plan_compile(&c->plan, c);
+}
+
+
+void
+earg_plan_dispose(struct earg *c) {
+    /* generated plans stay attached */
+    if ((c == NULL) || (c->plan == NULL) || c->plan->rodata) {
+        return;
+    }
+
+    plan_dispose(c->plan);
+    c->plan = NULL;
+}
+
+
+int
+earg_footprint(const struct earg *c, struct earg_footprint *f) {
+    size_t perdepth = sizeof(const char *) +
+        sizeof(const struct earg_command *);
+
+    if ((c == NULL) || (f == NULL)) {
+        return -1;
+    }
+
+    memset(f, 0, sizeof(struct earg_footprint));
+    if (plan_footprint(c, f)) {
+        return -1;
+    }
+
+    f->state = sizeof(struct earg_state);
+    f->statemin = f->state + f->options + f->depth * perdepth -
+        CONFIG_EARG_OPTIONS_MAX - CONFIG_EARG_CMDSTACK_MAX * perdepth;
+    f->tokenizer = sizeof(struct tokenizer);
+
+    if ((f->options > CONFIG_EARG_OPTIONS_MAX) ||
+            (f->depth > CONFIG_EARG_CMDSTACK_MAX)) {
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/* Consumes the tokens available so far. Returns with state->finished
+ * unset when the tokenizer needs more bytes. */
 static enum earg_status
-_command_parse(struct earg *c, struct tokenizer *t) {
+_consume(const struct earg *c, struct earg_state *state) {
     enum earg_status status = EARG_OK;
     enum tokenizer_status tokstatus;
     enum earg_eatstatus eatstatus;
     struct token tok;
-    struct token nexttok;
-    struct earg_state *state = c->state;
-    const struct earg_command *cmd = cmdstack_last(&state->cmdstack);
-    const struct earg_command *subcmd = NULL;
-    int arghint = arghint_parse(cmd->args);
+    struct tokenizer *t = &state->tokenizer;
+    const struct plannode *subnode;
+    const char *name;
+    int matches;
+    unsigned char *occurances;
 
-    if (optiondb_insertvector(&state->optiondb, cmd->options, cmd) == -1) {
-        status = EARG_FATAL;
-        goto terminate;
-    }
-
-    do {
+    for (;;) {
         /* fetch the next token */
-        if ((tokstatus = NEXT(t, &tok)) <= EARG_TOK_END) {
+        if ((tokstatus = NEXT(t, &tok)) == EARG_TOK_MORE) {
+            return EARG_OK;
+        }
+
+        if (tokstatus != EARG_TOK_END) {
+            STATS_INC(state, stats.tokens);
+        }
+
+        if (tokstatus <= EARG_TOK_END) {
             if (tokstatus == EARG_TOK_UNKNOWN) {
                 REJECT_OPTION_UNRECOGNIZED(state, tok.text, tok.len);
+                if (tok.dashes == 2) {
+                    _option_suggest(state, tok.text + 2,
+                            ((tok.eq >= 0)? tok.eq: tok.arglen) - 2);
+                }
+                status = EARG_USERERROR;
+            }
+            else if (tokstatus == EARG_TOK_AMBIGUOUS) {
+                REJECT_OPTION_AMBIGUOUS(state, tok.text, tok.len);
+                status = EARG_USERERROR;
+            }
+#if CONFIG_EARG_RESPONSEFILE_DEPTH
+            else if (tokstatus == EARG_TOK_RESPONSEFILE) {
+                REJECT_RESPONSEFILE(state, t, tok.text);
+                status = EARG_USERERROR;
+            }
+#endif
+            else if (tokstatus == EARG_TOK_ERROR) {
+                REJECT_SYNTAX(state);
+                status = EARG_USERERROR;
+            }
+            else if (state->pending) {
+                REJECT_OPTION_MISSINGARGUMENT(state, state->pending->option);
                 status = EARG_USERERROR;
             }
             goto terminate;
         }
 
+        /* excecutable name */
+        if (state->cmdstack.len == 0) {
+            if ((tokstatus != EARG_TOK_POSITIONAL) ||
+                    (cmdstack_push(&state->cmdstack, tok.text,
+                                   (struct earg_command *)c) == -1)) {
+                goto terminate;
+            }
+            continue;
+        }
+
+        /* the value of the previous option */
+        if (state->pending) {
+            tok.optioninfo = state->pending;
+            state->pending = NULL;
+            if (tokstatus != EARG_TOK_POSITIONAL) {
+                REJECT_OPTION_MISSINGARGUMENT(state, tok.optioninfo->option);
+                status = EARG_USERERROR;
+                goto terminate;
+            }
+
+            eatstatus = _eat(c, state, tok.optioninfo->command,
+                    tok.optioninfo, tok.text);
+            goto dessert;
+        }
+
         /* is this a positional? */
         if (tok.optioninfo == NULL) {
             /* is this a sub-command? */
-            subcmd = command_findbyname(cmd, tok.text);
-            if (subcmd) {
-                if (cmdstack_push(&state->cmdstack, tok.text, subcmd) == -1) {
-                    status = EARG_FATAL;
+            name = tok.text;
+            STATS_INC(state, stats.lookups);
+            subnode = plan_findchild(state->node, tok.text);
+            if ((subnode == NULL) && HASFLAG(c, EARG_ABBREV)) {
+                STATS_INC(state, stats.lookups);
+                subnode = plan_findchildbyprefix(state->node, tok.text,
+                        &matches);
+                if (matches > 1) {
+                    REJECT_COMMAND_AMBIGUOUS(state, tok.text);
+                    status = EARG_USERERROR;
+                    goto terminate;
                 }
-                else {
-                    status = _command_parse(c, t);
+
+                /* the chain is printed using the full names */
+                if (subnode) {
+                    name = subnode->command->name;
                 }
-                goto terminate;
+            }
+
+#if CONFIG_EARG_RESPONSEFILE_DEPTH
+            /* the chain outlives the response files */
+            if (subnode && t->depth) {
+                name = subnode->command->name;
+            }
+#endif
+
+            if (subnode) {
+                if (cmdstack_push(&state->cmdstack, name,
+                            subnode->command) == -1) {
+                    status = EARG_FATAL;
+                    goto terminate;
+                }
+                state->stray = NULL;
+
+                /* the sub-command's options are already compiled */
+                state->node = subnode;
+                tokenizer_optiondb(t, &subnode->optiondb);
+                continue;
             }
 
             /* it's positional */
             state->positionals++;
-            eatstatus = _eat(c, cmd, NULL, tok.text);
+            if (state->stray == NULL) {
+                state->stray = tok.text;
+            }
+            eatstatus = _eat(c, state, state->node->command, NULL, tok.text);
             goto dessert;
         }
 
-        /* ensure option occureances */
+        /* ensure option occureances, the multiple ones are counted too,
+         * for the environment */
+        occurances = state->occurances + tok.optioninfo->id;
         if ((!HASFLAG(tok.optioninfo->option, EARG_OPTION_MULTIPLE)) &&
-                (tok.optioninfo->occurances > 1)) {
+                *occurances) {
             REJECT_OPTION_REDUNDANT(state, tok.optioninfo->option);
             status = EARG_USERERROR;
             goto terminate;
         }
 
+        if (*occurances < (OCCURANCE_CONFIG - 1)) {
+            (*occurances)++;
+        }
+
 
         /* ensure option's value */
         if (EARG_OPTION_ARGNEEDED(tok.optioninfo->option)) {
             if (tok.text == NULL) {
-                /* try the next token as value */
-                if ((tokstatus = NEXT(t, &nexttok))
-                        != EARG_TOK_POSITIONAL) {
-                    REJECT_OPTION_MISSINGARGUMENT(state,
-                            tok.optioninfo->option);
-                    status = EARG_USERERROR;
-                    goto terminate;
-                }
-
-                tok.text = nexttok.text;
-                tok.len = nexttok.len;
+                /* the next token is the value */
+                state->pending = tok.optioninfo;
+                continue;
             }
-            eatstatus = _eat(c, tok.optioninfo->command,
-                    tok.optioninfo->option, tok.text);
+            eatstatus = _eat(c, state, tok.optioninfo->command,
+                    tok.optioninfo, tok.text);
         }
         else {
             if (tok.text) {
@@ -292,8 +605,8 @@ _command_parse(struct earg *c, struct tokenizer *t) {
                 status = EARG_USERERROR;
                 goto terminate;
             }
-            eatstatus = _eat(c, tok.optioninfo->command,
-                    tok.optioninfo->option, NULL);
+            eatstatus = _eat(c, state, tok.optioninfo->command,
+                    tok.optioninfo, NULL);
         }
 
 dessert:
@@ -305,6 +618,20 @@ dessert:
                 goto terminate;
             case EARG_EAT_UNRECOGNIZED:
                 REJECT_POSITIONAL(state, tok.text);
+                if (tok.optioninfo == NULL) {
+                    _command_suggest(state, tok.text);
+                }
+                status = EARG_USERERROR;
+                goto terminate;
+            case EARG_EAT_INVALID:
+                if (tok.optioninfo) {
+                    REJECT_OPTION_INVALID(state, tok.optioninfo->option,
+                            tok.text? tok.text: "");
+                }
+                else {
+                    REJECT_POSITIONAL(state, tok.text);
+                    _command_suggest(state, tok.text);
+                }
                 status = EARG_USERERROR;
                 goto terminate;
             case EARG_EAT_NOTEATEN:
@@ -320,80 +647,549 @@ dessert:
                 status = EARG_FATAL;
                 goto terminate;
         }
-    } while (tokstatus > EARG_TOK_END);
+    }
 
 terminate:
-    if ((status == EARG_OK) && (subcmd == NULL) &&
-            arghint_validate(state->positionals, arghint)) {
-        REJECT_POSITIONALCOUNT(state);
-        status = EARG_USERERROR;
+    state->finished = true;
+    return status;
+}
+
+
+/* PREFIX_DRY_RUN=... is dry-run, returns the length of the option name
+ * or -1 if the variable is not one of ours. */
+static int
+_environ_optionname(const char *var, const char *prefix, size_t prefixlen,
+        char *name) {
+    int len;
+
+    if (strncmp(var, prefix, prefixlen)) {
+        return -1;
     }
 
-    return status;
+    var += prefixlen;
+    for (len = 0; var[len] && (var[len] != '='); len++) {
+        if (len == (ENVIRON_NAMEMAX - 1)) {
+            return -1;
+        }
+        name[len] = (var[len] == '_')? '-': tolower((unsigned char)var[len]);
+    }
+
+    if ((len == 0) || (var[len] != '=')) {
+        return -1;
+    }
+
+    return len;
 }
 
 
-enum earg_status
-earg_parse(struct earg *c, int argc, const char **argv,
-        const struct earg_command **command) {
-    struct earg_state *state;
-    enum earg_status status = EARG_OK;
-    enum tokenizer_status tokstatus;
-    struct token tok;
-    struct tokenizer *t;
+/* Options of the final command which are not given on the command line
+ * are eaten from the environment, in a single pass over the variables. */
+static enum earg_status
+_environ_eat(const struct earg *c, struct earg_state *state,
+        char * const *vars) {
+    char * const *var;
+    char name[ENVIRON_NAMEMAX];
+    size_t prefixlen = strlen(c->envprefix);
+    const struct optioninfo *info;
+    const char *value;
+    enum earg_eatstatus eatstatus;
+    bool flag;
+    int len;
 
-    if (argc < 1) {
-        return EARG_FATAL;
+    for (var = vars; var && *var; var++) {
+        len = _environ_optionname(*var, c->envprefix, prefixlen, name);
+        if (len == -1) {
+            continue;
+        }
+
+        STATS_INC(state, stats.probes);
+        info = optiondb_findbyname(&state->node->optiondb, name, len);
+
+        /* the command line wins, builtins are taken only with a value */
+        if ((info == NULL) || state->occurances[info->id] ||
+                (info->builtin && !EARG_OPTION_ARGNEEDED(info->option))) {
+            continue;
+        }
+        state->occurances[info->id] = 1;
+        value = *var + prefixlen + len + 1;
+
+        /* plain flags are eaten if the value is true */
+        if (EARG_OPTION_ARGNEEDED(info->option) || info->option->type) {
+            eatstatus = _eat(c, state, info->command, info, value);
+        }
+        else if (binding_bool(value, &flag)) {
+            eatstatus = EARG_EAT_INVALID;
+        }
+        else if (flag) {
+            eatstatus = _eat(c, state, info->command, info, NULL);
+        }
+        else {
+            continue;
+        }
+
+        switch (eatstatus) {
+            case EARG_EAT_OK:
+                continue;
+            case EARG_EAT_OK_EXIT:
+                return EARG_OK_EXIT;
+            case EARG_EAT_NOTEATEN:
+                REJECT_OPTION_NOTEATEN(state, info->option);
+                return EARG_FATAL;
+            case EARG_EAT_UNRECOGNIZED:
+            case EARG_EAT_INVALID:
+                REJECT_ENVIRON_INVALID(state, *var, (int)prefixlen + len,
+                        value);
+                return EARG_USERERROR;
+            default:
+                return EARG_FATAL;
+        }
     }
 
-    state = malloc(sizeof(struct earg_state));
-    if (state == NULL) {
-        return EARG_FATAL;
+    return EARG_OK;
+}
+
+
+static bool
+_config_onchain(const struct plannode *node,
+        const struct plannode *section) {
+    for (; node; node = node->parent) {
+        if (node == section) {
+            return true;
+        }
     }
-    memset(state, 0, sizeof(struct earg_state));
-    state->positionals = 0;
-    c->state = state;
 
-    if (_build_optiondb(c, &state->optiondb)) {
-        return EARG_FATAL;
+    return false;
+}
+
+
+/* Eats the entries of the sections on the command chain, section by
+ * section, the options given on the command line or in the environment
+ * are skipped. */
+static enum earg_status
+_config_eat(const struct earg *c, struct earg_state *state,
+        const struct configtable *table) {
+    enum earg_eatstatus eatstatus;
+    const struct configentry *entry;
+    const struct plannode *section = state->node;
+    const char *path = c->configfile;
+    const struct optioninfo *info;
+    unsigned char *occurances;
+    bool flag;
+    int i;
+
+    if (table->error) {
+        REJECT_CONFIG_FILE(state, path, table->error);
+        return EARG_USERERROR;
     }
 
-    t = tokenizer_new(argc, argv, &state->optiondb);
-    if (t == NULL) {
-        optiondb_dispose(&state->optiondb);
-        return EARG_FATAL;
+    /* entries before the first section belong to the root */
+    while (section->parent) {
+        section = section->parent;
     }
 
-    /* initialize command stack */
-    cmdstack_init(&state->cmdstack);
+    for (i = 0; i < table->count; i++) {
+        entry = table->entries + i;
+        if (entry->section) {
+            section = entry->node;
+            if (section == NULL) {
+                REJECT_CONFIG(state, path, entry, "invalid section",
+                        entry->key);
+                return EARG_USERERROR;
+            }
 
-    /* excecutable name */
-    if ((tokstatus = NEXT(t, &tok)) != EARG_TOK_POSITIONAL) {
-        goto terminate;
+            /* the other commands' sections are skipped */
+            if (!_config_onchain(state->node, section)) {
+                section = NULL;
+            }
+            continue;
+        }
+
+        if (section == NULL) {
+            continue;
+        }
+
+        STATS_INC(state, stats.probes);
+        info = optiondb_findbyname(&section->optiondb, entry->key,
+                strlen(entry->key));
+        if ((info == NULL) ||
+                (info->builtin && !EARG_OPTION_ARGNEEDED(info->option))) {
+            REJECT_CONFIG(state, path, entry, "invalid option", entry->key);
+            return EARG_USERERROR;
+        }
+
+        /* the command line and the environment win */
+        occurances = state->occurances + info->id;
+        if (*occurances && (*occurances != OCCURANCE_CONFIG)) {
+            continue;
+        }
+
+        if (*occurances && !HASFLAG(info->option, EARG_OPTION_MULTIPLE)) {
+            REJECT_CONFIG(state, path, entry, "redundant option",
+                    entry->key);
+            return EARG_USERERROR;
+        }
+        *occurances = OCCURANCE_CONFIG;
+
+        /* bare keys are flags, plain flags are eaten if the value is true */
+        if (EARG_OPTION_ARGNEEDED(info->option)) {
+            eatstatus = entry->value? _eat(c, state, info->command, info,
+                    entry->value): EARG_EAT_INVALID;
+        }
+        else if (info->option->type) {
+            eatstatus = _eat(c, state, info->command, info, entry->value);
+        }
+        else if (entry->value && binding_bool(entry->value, &flag)) {
+            eatstatus = EARG_EAT_INVALID;
+        }
+        else if (entry->value && !flag) {
+            continue;
+        }
+        else {
+            eatstatus = _eat(c, state, info->command, info, NULL);
+        }
+
+        switch (eatstatus) {
+            case EARG_EAT_OK:
+                continue;
+            case EARG_EAT_OK_EXIT:
+                return EARG_OK_EXIT;
+            case EARG_EAT_NOTEATEN:
+                REJECT_OPTION_NOTEATEN(state, info->option);
+                return EARG_FATAL;
+            case EARG_EAT_UNRECOGNIZED:
+            case EARG_EAT_INVALID:
+                REJECT_CONFIG_INVALID(state, path, entry, entry->key,
+                        entry->value? entry->value: "");
+                return EARG_USERERROR;
+            default:
+                return EARG_FATAL;
+        }
     }
 
-    if (cmdstack_push(&state->cmdstack, tok.text,
-                (struct earg_command *)c) == -1) {
-        goto terminate;
+    if (table->status == CONFIGFILE_ERROR) {
+        REJECT_CONFIG_SYNTAX(state, path, table);
+        return EARG_USERERROR;
+    }
+
+    return EARG_OK;
+}
+
+
+/* The config file is read on each parse, or once by earg_parse_batch() */
+static enum earg_status
+_config_read(const struct earg *c, struct earg_state *state) {
+    enum earg_status status;
+    struct configtable table;
+    const struct plannode *root = state->node;
+
+    if (state->defaults) {
+        return _config_eat(c, state, &state->defaults->config);
+    }
+
+    while (root->parent) {
+        root = root->parent;
+    }
+
+    defaults_config(&table, c, root);
+    status = _config_eat(c, state, &table);
+    configfile_unload(&table, c->allocator);
+    return status;
+}
+
+
+static enum earg_status
+_finish(const struct earg *c, struct earg_state *state,
+        enum earg_status status, const struct earg_command **command) {
+    if (state->cmdstack.len == 0) {
+        goto flush;
+    }
+
+    if ((status == EARG_OK) &&
+            arghint_validate(state->positionals, state->node->arghint)) {
+        REJECT_POSITIONALCOUNT(state);
+        if (state->stray) {
+            _command_suggest(state, state->stray);
+        }
+        status = EARG_USERERROR;
+    }
+
+    if ((status == EARG_OK) && c->envprefix) {
+        status = _environ_eat(c, state,
+                state->defaults? state->defaults->environ: environ);
+    }
+
+    if ((status == EARG_OK) && c->configfile) {
+        status = _config_read(c, state);
     }
-    c->name = tok.text;
 
-    status = _command_parse(c, t);
     if (status < EARG_OK) {
         goto terminate;
     }
 
+    /* a batch reports it per line instead, see earg_batchresult */
+    if (state->defaults == NULL) {
+        _verbosity_apply(state);
+    }
+
     /* commands */
     if (command) {
         *command = cmdstack_last(&state->cmdstack);
     }
 
 terminate:
-    tokenizer_dispose(t);
-    optiondb_dispose(&state->optiondb);
     if (status == EARG_USERERROR) {
         TRYHELP(state);
     }
+
+flush:
+    /* each stream is written at once */
+    sink_flush(&state->out);
+    sink_flush(&state->err);
+#ifdef CONFIG_EARG_STATS
+    stats_end(state, status);
+#endif
+#if CONFIG_EARG_RESPONSEFILE_DEPTH
+    tokenizer_dispose(&state->tokenizer);
+#endif
+    return status;
+}
+
+
+/* What the state takes from the tree for a parse */
+static void
+_settings(const struct earg *c, struct earg_state *state) {
+    struct tokenizer *t = &state->tokenizer;
+
+    state->out.allocator = c->allocator;
+    state->err.allocator = c->allocator;
+    t->abbrev = HASFLAG(c, EARG_ABBREV);
+#if CONFIG_EARG_RESPONSEFILE_DEPTH
+    t->responsefiles = HASFLAG(c, EARG_RESPONSEFILE);
+    t->allocator = c->allocator;
+#endif
+}
+
+
+static enum earg_status
+_parse(const struct earg *c, struct earg_state *state,
+        const struct earg_command **command) {
+    _settings(c, state);
+    return _finish(c, state, _consume(c, state), command);
+}
+
+
+size_t
+earg_state_size() {
+    return sizeof(struct earg_state);
+}
+
+
+earg_state_t
+earg_state_init(void *buff, size_t size) {
+    struct earg_state *state = buff;
+
+    if ((buff == NULL) || (size < sizeof(struct earg_state))) {
+        return NULL;
+    }
+
+    if (((uintptr_t)buff) % _Alignof(struct earg_state)) {
+        return NULL;
+    }
+
+    memset(state, 0, sizeof(struct earg_state));
+    sink_init(&state->out, earg_sink_file, stdout, state->outbuff,
+            sizeof(state->outbuff), NULL);
+    sink_init(&state->err, earg_sink_file, stderr, state->errbuff,
+            sizeof(state->errbuff), NULL);
+    return state;
+}
+
+
+void
+earg_state_sinks(earg_state_t state, const struct earg_sink *out,
+        const struct earg_sink *err) {
+    if (out) {
+        sink_flush(&state->out);
+        sink_init(&state->out, out->write, out->ptr,
+                out->buff? out->buff: state->outbuff,
+                out->buff? out->size: sizeof(state->outbuff),
+                state->out.allocator);
+    }
+
+    if (err) {
+        sink_flush(&state->err);
+        sink_init(&state->err, err->write, err->ptr,
+                err->buff? err->buff: state->errbuff,
+                err->buff? err->size: sizeof(state->errbuff),
+                state->err.allocator);
+    }
+}
+
+
+void
+earg_state_reset(earg_state_t state) {
+#if CONFIG_EARG_RESPONSEFILE_DEPTH
+    /* an unfinished earg_feed() */
+    tokenizer_dispose(&state->tokenizer);
+#endif
+    cmdstack_init(&state->cmdstack);
+    state->node = NULL;
+    state->pending = NULL;
+    state->finished = false;
+    state->status = EARG_OK;
+    state->positionals = 0;
+    state->stray = NULL;
+    state->verbosity = ELOG_UNKNOWN;
+    memset(state->occurances, 0, sizeof(state->occurances));
+#ifdef CONFIG_EARG_STATS
+    stats_begin(state);
+#endif
+}
+
+
+enum earg_status
+earg_parse_r(const struct earg *c, earg_state_t state, int argc,
+        const char **argv, const struct earg_command **command) {
+    if ((c == NULL) || (state == NULL) || (c->plan == NULL)) {
+        return EARG_FATAL;
+    }
+
+    if (argc < 1) {
+        return EARG_FATAL;
+    }
+
+    earg_state_reset(state);
+    state->node = c->plan->nodes;
+    tokenizer_init(&state->tokenizer, argc, argv, &state->node->optiondb);
+    return _parse(c, state, command);
+}
+
+
+enum earg_status
+earg_parse_line(const struct earg *c, earg_state_t state, char *line,
+        const struct earg_command **command) {
+    size_t len;
+
+    if ((c == NULL) || (state == NULL) || (c->plan == NULL) ||
+            (line == NULL)) {
+        return EARG_FATAL;
+    }
+
+    earg_state_reset(state);
+    state->node = c->plan->nodes;
+    len = strlen(line);
+    tokenizer_initline(&state->tokenizer, line, len, len + 1, true,
+            &state->node->optiondb);
+    return _parse(c, state, command);
+}
+
+
+int
+earg_feed_begin(const struct earg *c, earg_state_t state, char *buff,
+        size_t size) {
+    if ((c == NULL) || (state == NULL) || (c->plan == NULL) ||
+            (buff == NULL) || (size == 0)) {
+        return -1;
+    }
+
+    earg_state_reset(state);
+    state->earg = c;
+    state->node = c->plan->nodes;
+    tokenizer_initline(&state->tokenizer, buff, 0, size, false,
+            &state->node->optiondb);
+    _settings(c, state);
+    return 0;
+}
+
+
+enum earg_status
+earg_feed(earg_state_t state, const char *bytes, size_t n) {
+    if (state->finished) {
+        return state->status;
+    }
+
+    if (splitter_feed(&state->tokenizer.splitter, bytes, n)) {
+        SERR(state, "line is too long\n");
+        state->finished = true;
+        state->status = EARG_USERERROR;
+        return state->status;
+    }
+
+    state->status = _consume(state->earg, state);
+    return state->status;
+}
+
+
+enum earg_status
+earg_feed_end(earg_state_t state, const struct earg_command **command) {
+    if (!state->finished) {
+        splitter_eol(&state->tokenizer.splitter);
+        state->status = _consume(state->earg, state);
+    }
+
+    return _finish(state->earg, state, state->status, command);
+}
+
+
+#ifdef CONFIG_EARG_STATE_STATIC
+static struct earg_state _state;
+
+/* the tree the static state belongs to, until earg_dispose() */
+static const struct earg *_owner;
+#endif
+
+
+enum earg_status
+earg_parse(struct earg *c, int argc, const char **argv,
+        const struct earg_command **command) {
+    struct earg_state *state = c->state;
+    const struct earg_plan *plan;
+    enum earg_status status;
+    size_t heap = 0;
+
+    /* the state is allocated once and reused by the next calls */
+    if (state == NULL) {
+#ifdef CONFIG_EARG_STATE_STATIC
+        if (_owner) {
+            PERR("the static state is in use by another tree, "
+                    "earg_dispose() it first\n");
+            return EARG_FATAL;
+        }
+        _owner = c;
+        state = earg_state_init(&_state, sizeof(_state));
+#else
+        state = allocator_malloc(c->allocator, sizeof(struct earg_state));
+        if (state == NULL) {
+            return EARG_FATAL;
+        }
+        earg_state_init(state, sizeof(struct earg_state));
+        heap += sizeof(struct earg_state);
+#endif
+        c->state = state;
+    }
+
+    /* uncompiled trees are compiled on the first call */
+    if ((c->plan == NULL) && (state->plan == NULL)) {
+        if (plan_compile(&state->plan, c)) {
+            return EARG_FATAL;
+        }
+        heap += state->plan->size;
+    }
+
+    if (argc < 1) {
+        return EARG_FATAL;
+    }
+
+    plan = c->plan? c->plan: state->plan;
+    earg_state_reset(state);
+    STATS_ADD(state, stats.heap, heap);
+    state->node = plan->nodes;
+    tokenizer_init(&state->tokenizer, argc, argv, &state->node->optiondb);
+    status = _parse(c, state, command);
+    if (state->cmdstack.len) {
+        c->name = state->cmdstack.names[0];
+    }
+
     return status;
 }
 
@@ -408,12 +1204,55 @@ earg_dispose(struct earg *c) {
         return -1;
     }
 
-    free(c->state);
+    plan_dispose(c->state->plan);
+#ifdef CONFIG_EARG_STATE_STATIC
+    _owner = NULL;
+#else
+    allocator_free(c->allocator, c->state);
+#endif
     c->state = NULL;
     return 0;
 }
 
 
+int
+earg_state_verbosity(earg_state_t state) {
+    return state->verbosity;
+}
+
+
+int
+earg_state_try_help(earg_state_t state) {
+    if ((state == NULL) || (state->cmdstack.len == 0)) {
+        return -1;
+    }
+
+    TRYHELP(state);
+    return sink_flush(&state->err);
+}
+
+
+int
+earg_state_commandchain_print(FILE *file, earg_state_t state) {
+    int bytes;
+    char buff[CONFIG_EARG_SINK_BUFFSIZE];
+    struct earg_sink sink;
+
+    if (state == NULL) {
+        return -1;
+    }
+
+    sink_init(&sink, earg_sink_file, file, buff, sizeof(buff),
+            state->err.allocator);
+    bytes = cmdstack_print(&sink, &state->cmdstack);
+    if (sink_flush(&sink)) {
+        return -1;
+    }
+
+    return bytes;
+}
+
+
 int
 earg_try_help(const struct earg* c) {
     if (c == NULL) {
@@ -425,7 +1264,7 @@ earg_try_help(const struct earg* c) {
     }
 
     TRYHELP(c->state);
-    return 0;
+    return sink_flush(&c->state->err);
 }
 
 
@@ -435,5 +1274,5 @@ earg_commandchain_print(FILE *file, const struct earg *c) {
         return -1;
     }
 
-    return cmdstack_print(file, &c->state->cmdstack);
+    return earg_state_commandchain_print(file, c->state);
 }
@@ -16,33 +16,26 @@
  *
  *  Author: Vahid Mardani <vahid.mardani@gmail.com>
  */
-#include <stdlib.h>
-#include <string.h>
+#ifndef HASH_H_
+#define HASH_H_
 
-#include "command.h"
-#include "toolbox.h"
 
+#define HASH_FNV1A_BASIS 2166136261u
 
-const struct earg_command *
-command_findbyname(const struct earg_command *cmd, const char *name) {
-    if (name == NULL) {
-        return NULL;
-    }
-
-    if ((cmd == NULL) || (cmd->commands == NULL)) {
-        return NULL;
-    }
 
-    const struct earg_command **c = cmd->commands;
-    const struct earg_command *s;
+/* FNV-1a, shared by all lookup tables and the table generator. The
+ * generator searches for a seed that makes its tables collision free. */
+static inline unsigned int
+hash_fnv1a(unsigned int seed, const char *s, int len) {
+    unsigned int h = seed;
 
-    while ((s = *c)) {
-        if (STREQ(name, s->name)) {
-            return (const struct earg_command *)s;
-        }
-
-        c++;
+    while (len--) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
     }
 
-    return NULL;
+    return h;
 }
+
+
+#endif  // HASH_H_
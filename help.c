@@ -23,8 +23,11 @@
 #include <ctype.h>
 
 #include "toolbox.h"
+#include "allocator.h"
 #include "builtin.h"
 #include "state.h"
+#include "sink.h"
+#include "help.h"
 
 
 #define OPT_MINGAP 4
@@ -58,17 +61,106 @@ _calculate_initial_gapsize(const struct earg *c, bool subcommand) {
 }
 
 
+#ifdef CONFIG_EARG_HELP_COMPRESS
+
+/* Compressed texts, bytes 0x80 - 0xfe refer to the dictionary entries
+ * and 0xff escapes the next byte. */
+#define DICT_FIRST 0x80
+#define DICT_ESCAPE 0xff
+
+
+static void
+_expand(const char * const *dict, const char *s, char *buff, size_t size) {
+    const unsigned char *c = (const unsigned char *)s;
+    const char *entry;
+    size_t len = 0;
+    size_t elen;
+
+    for (; *c && (len < (size - 1)); c++) {
+        if (*c < DICT_FIRST) {
+            buff[len++] = *c;
+            continue;
+        }
+
+        if (*c == DICT_ESCAPE) {
+            buff[len++] = *(++c);
+            continue;
+        }
+
+        entry = dict[*c - DICT_FIRST];
+        elen = MIN(strlen(entry), size - 1 - len);
+        memcpy(buff + len, entry, elen);
+        len += elen;
+    }
+
+    buff[len] = 0;
+}
+
+
+#ifdef CONFIG_EARG_HELP_CACHE
+
+/* the cached help is expanded while it's printed */
+static void
+_expand_print(struct earg_sink *sink, const char * const *dict,
+        const char *s) {
+    const unsigned char *c = (const unsigned char *)s;
+    const unsigned char *literal = c;
+    const char *entry;
+
+    for (; *c; c++) {
+        if (*c < DICT_FIRST) {
+            continue;
+        }
+
+        sink_write(sink, (const char *)literal, c - literal);
+        if (*c == DICT_ESCAPE) {
+            sink_write(sink, (const char *)(++c), 1);
+        }
+        else {
+            entry = dict[*c - DICT_FIRST];
+            sink_write(sink, entry, strlen(entry));
+        }
+        literal = c + 1;
+    }
+
+    sink_write(sink, (const char *)literal, c - literal);
+}
+
+#endif
+#endif
+
+
+/* it belongs to the tree, a plan compiled from a generated tree doesn't
+ * have one */
+static const char * const *
+_dictionary(const struct earg *c) {
+    return c->dictionary;
+}
+
+
 static void
-_print_multiline(FILE *file, const char *string, int indent, int linemax) {
+_print_multiline(struct earg_sink *sink, const char * const *dict,
+        const char *string, int indent, int linemax) {
     int remain;
     int linesize = linemax - indent;
     int ls;
     bool dash = false;
+#ifdef CONFIG_EARG_HELP_COMPRESS
+    char buff[CONFIG_EARG_HELP_COMPRESS_BUFFSIZE];
+#endif
 
     if (string == NULL) {
         return;
     }
 
+#ifdef CONFIG_EARG_HELP_COMPRESS
+    /* expand only the text being printed */
+    if (dict) {
+        _expand(dict, string, buff, sizeof(buff));
+        string = buff;
+    }
+#endif
+
     remain = strlen(string);
     while (remain) {
         dash = false;
@@ -78,7 +170,7 @@ _print_multiline(FILE *file, const char *string, int indent, int linemax) {
         }
 
         if (remain <= linesize) {
-            fprintf(file, "%s\n", string);
+            sink_printf(sink, "%s\n", string);
             remain = 0;
             break;
         }
@@ -97,87 +189,97 @@ _print_multiline(FILE *file, const char *string, int indent, int linemax) {
             ls--;
         }
 
-        fprintf(file, "%.*s%s\n", ls, string, dash? "-": "");
+        sink_printf(sink, "%.*s%s\n", ls, string, dash? "-": "");
         remain -= ls;
         string += ls;
-        fprintf(file, "%*s", indent, "");
+        sink_printf(sink, "%*s", indent, "");
     }
 }
 
 
 static void
-_print_optiongroup(FILE *file, const struct earg_option *opt, int gapsize) {
+_print_optiongroup(struct earg_sink *sink, const char * const *dict,
+        const struct earg_option *opt, int gapsize) {
     int rpad;
 
     if (opt->name && (!STREQ("-", opt->name))) {
         rpad = (gapsize + 8) - strlen(opt->name);
-        fprintf(file, "\n%s%*s", opt->name, rpad, "");
+        sink_printf(sink, "\n%s%*s", opt->name, rpad, "");
     }
 
     if (opt->help) {
-        _print_multiline(file, opt->help, gapsize + 8, CONFIG_EARG_HELP_LINESIZE);
+        _print_multiline(sink, dict, opt->help, gapsize + 8,
+                CONFIG_EARG_HELP_LINESIZE);
     }
     else {
-        fprintf(file, "\n");
+        sink_printf(sink, "\n");
     }
 }
 
 
 static void
-_print_subcommands(FILE *file, const struct earg_command *cmd) {
+_print_subcommands(struct earg_sink *sink,
+        const struct earg_command *cmd) {
     const struct earg_command **c = cmd->commands;
     const struct earg_command *s;
+    const char * const *alias;
 
     if (cmd->commands == NULL) {
         return;
     }
 
-    fprintf(file, "\nCommands:\n");
+    sink_printf(sink, "\nCommands:\n");
     while ((s = *c)) {
-        fprintf(file, "  %s\n", s->name);
+        sink_printf(sink, "  %s", s->name);
+        for (alias = s->aliases; alias && *alias; alias++) {
+            sink_printf(sink, ", %s", *alias);
+        }
+        sink_printf(sink, "\n");
         c++;
     }
 }
 
 
 static void
-_print_option(FILE *file, const struct earg_option *opt, int gapsize) {
+_print_option(struct earg_sink *sink, const char * const *dict,
+        const struct earg_option *opt, int gapsize) {
     int rpad = gapsize - OPT_HELPLEN(opt);
 
     if (ISCHAR(opt->key)) {
-        fprintf(file, "  -%c%c ", opt->key, opt->name? ',': ' ');
+        sink_printf(sink, "  -%c%c ", opt->key, opt->name? ',': ' ');
     }
     else {
-        fprintf(file, "      ");
+        sink_printf(sink, "      ");
     }
 
     if (opt->name) {
         if (opt->arg == NULL) {
-            fprintf(file, "--%s%*s", opt->name, rpad, "");
+            sink_printf(sink, "--%s%*s", opt->name, rpad, "");
         }
         else {
-            fprintf(file, "--%s=%s%*s", opt->name, opt->arg, rpad, "");
+            sink_printf(sink, "--%s=%s%*s", opt->name, opt->arg, rpad, "");
         }
     }
     else {
-        fprintf(file, "  %*s", rpad, "");
+        sink_printf(sink, "  %*s", rpad, "");
     }
 
     if (opt->help) {
-        _print_multiline(file, opt->help, gapsize + 8, CONFIG_EARG_HELP_LINESIZE);
+        _print_multiline(sink, dict, opt->help, gapsize + 8,
+                CONFIG_EARG_HELP_LINESIZE);
     }
     else {
-        fprintf(file, "\n");
+        sink_printf(sink, "\n");
     }
 }
 
 
-static void
-_print_options(FILE *file, const struct earg *c, const struct earg_command *cmd) {
+int
+help_gapsize(const struct earg *c, const struct earg_command *cmd,
+        bool subcommand) {
     int gapsize;
     int i = 0;
     const struct earg_option *opt;
-    bool subcommand = c->state->cmdstack.len > 1;
 
     /* calculate gap size between options and description */
     gapsize = _calculate_initial_gapsize(c, subcommand);
@@ -190,23 +292,37 @@ _print_options(FILE *file, const struct earg *c, const struct earg_command *cmd)
         gapsize = MAX(gapsize, OPT_HELPLEN(opt) + OPT_MINGAP);
     }
 
-    fprintf(file, "\nOptions:\n");
+    return gapsize;
+}
+
+
+static void
+_print_options(struct earg_sink *sink, const struct earg *c,
+        const struct plannode *node) {
+    int i = 0;
+    const struct earg_option *opt;
+    const struct earg_command *cmd = node->command;
+    bool subcommand = node->parent != NULL;
+    int gapsize = node->gapsize;
+    const char * const *dict = _dictionary(c);
+
+    sink_printf(sink, "\nOptions:\n");
     if (!HASFLAG(c, EARG_NOHELP)) {
-        _print_option(file, &opt_help, gapsize);
+        _print_option(sink, dict, &opt_help, gapsize);
     }
 
     if (!HASFLAG(c, EARG_NOUSAGE)) {
-        _print_option(file, &opt_usage, gapsize);
+        _print_option(sink, dict, &opt_usage, gapsize);
     }
 
     if ((!subcommand) && (!HASFLAG(c, EARG_NOELOG))) {
-        _print_option(file, &opt_verboseflag, gapsize);
-        _print_option(file, &opt_quietflag, gapsize);
-        _print_option(file, &opt_verbosity, gapsize);
+        _print_option(sink, dict, &opt_verboseflag, gapsize);
+        _print_option(sink, dict, &opt_quietflag, gapsize);
+        _print_option(sink, dict, &opt_verbosity, gapsize);
     }
 
     if (!subcommand && c->version) {
-        _print_option(file, &opt_version, gapsize);
+        _print_option(sink, dict, &opt_version, gapsize);
     }
 
     i = 0;
@@ -217,80 +333,153 @@ _print_options(FILE *file, const struct earg *c, const struct earg_command *cmd)
         }
 
         if (opt->key) {
-            _print_option(file, opt, gapsize);
+            _print_option(sink, dict, opt, gapsize);
         }
         else {
-            _print_optiongroup(file, opt, gapsize);
+            _print_optiongroup(sink, dict, opt, gapsize);
         }
     }
 }
 
 
 void
-earg_usage_print(FILE *file, const struct earg *c) {
-    char delim[1] = {'\n'};
-    char *needle;
-    char *saveptr = NULL;
-    char *buff = NULL;
-    struct earg_state *state = c->state;
+help_usage_print(struct earg_sink *sink, const struct earg *c,
+        struct earg_state *state) {
+    const char *needle;
+    const char *end;
     const struct earg_command *cmd = cmdstack_last(&state->cmdstack);
+    bool first = true;
 
-    POUT("Usage: ");
-    cmdstack_print(file, &state->cmdstack);
-    POUT(" [OPTION...]");
+    sink_printf(sink, "Usage: ");
+    cmdstack_print(sink, &state->cmdstack);
+    sink_printf(sink, " [OPTION...]");
 
-    if (cmd->args == NULL) {
-        goto done;
-    }
+    /* one usage line per line of args */
+    for (needle = cmd->args; needle && *needle; needle = end) {
+        end = strchr(needle, '\n');
+        if (end == NULL) {
+            end = needle + strlen(needle);
+        }
 
-    buff = malloc(strlen(cmd->args) + 1);
-    strcpy(buff, cmd->args);
+        if (end > needle) {
+            if (!first) {
+                sink_printf(sink, "\n   or: ");
+                cmdstack_print(sink, &state->cmdstack);
+                sink_printf(sink, " [OPTION...]");
+            }
+            sink_printf(sink, " %.*s", (int)(end - needle), needle);
+            first = false;
+        }
 
-    needle = strtok_r(buff, delim, &saveptr);
-    POUT(" %s", needle);
-    while (true) {
-        needle = strtok_r(NULL, delim, &saveptr);
-        if (needle == NULL) {
-            break;
+        if (*end) {
+            end++;
         }
-        POUT("\n   or: ");
-        cmdstack_print(file, &state->cmdstack);
-        POUT(" [OPTION...] %s", needle);
     }
 
-done:
-    if (buff) {
-        free(buff);
-    }
-    POUT("\n");
+    sink_printf(sink, "\n");
 }
 
 
-void
-earg_help_print(FILE *file, const struct earg *c) {
-    struct earg_state *state = c->state;
-    const struct earg_command *cmd = cmdstack_last(&state->cmdstack);
-
-    /* usage */
-    earg_usage_print(file, c);
+/* Everything after the usage lines, it only depends on the node. */
+static void
+_print_body(struct earg_sink *sink, const struct earg *c,
+        const struct plannode *node) {
+    const struct earg_command *cmd = node->command;
+    const char * const *dict = _dictionary(c);
 
     /* header */
     if (cmd->header) {
-        POUT("\n");
-        _print_multiline(file, cmd->header, 0, CONFIG_EARG_HELP_LINESIZE);
+        sink_printf(sink, "\n");
+        _print_multiline(sink, dict, cmd->header, 0,
+                CONFIG_EARG_HELP_LINESIZE);
     }
 
     /* sub-commands */
     if (cmd->commands) {
-        _print_subcommands(file, cmd);
+        _print_subcommands(sink, cmd);
     }
 
     /* options */
-    _print_options(file, c, cmd);
+    _print_options(sink, c, node);
 
     /* footer */
     if (cmd->footer) {
-        POUT("\n");
-        _print_multiline(file, cmd->footer, 0, CONFIG_EARG_HELP_LINESIZE);
+        sink_printf(sink, "\n");
+        _print_multiline(sink, dict, cmd->footer, 0,
+                CONFIG_EARG_HELP_LINESIZE);
+    }
+}
+
+
+#ifdef CONFIG_EARG_HELP_CACHE
+
+int
+help_render(const struct earg *c, struct plannode *node) {
+    char buff[CONFIG_EARG_SINK_BUFFSIZE];
+    struct sinkbuffer body = {NULL, 0, 0, false, c->allocator};
+    struct earg_sink sink;
+
+    sink_init(&sink, sink_collect, &body, buff, sizeof(buff), c->allocator);
+    _print_body(&sink, c, node);
+    sink_flush(&sink);
+    if (body.failed) {
+        allocator_free(c->allocator, body.buff);
+        return -1;
+    }
+
+    node->help = body.buff;
+    node->helplen = body.len;
+    return 0;
+}
+
+#endif
+
+
+void
+help_print(struct earg_sink *sink, const struct earg *c,
+        struct earg_state *state) {
+#if defined(CONFIG_EARG_HELP_CACHE) && defined(CONFIG_EARG_HELP_COMPRESS)
+    const struct earg_plan *plan;
+#endif
+
+    help_usage_print(sink, c, state);
+
+#ifdef CONFIG_EARG_HELP_CACHE
+    /* rendered once by the plan, generated ones keep it compressed */
+    if (state->node->help) {
+#ifdef CONFIG_EARG_HELP_COMPRESS
+        plan = c->plan? c->plan: state->plan;
+        if (plan->dictionary) {
+            _expand_print(sink, plan->dictionary, state->node->help);
+            return;
+        }
+#endif
+        sink_write(sink, state->node->help, state->node->helplen);
+        return;
     }
+#endif
+
+    _print_body(sink, c, state->node);
+}
+
+
+void
+earg_usage_print(FILE *file, const struct earg *c) {
+    char buff[CONFIG_EARG_SINK_BUFFSIZE];
+    struct earg_sink sink;
+
+    sink_init(&sink, earg_sink_file, file, buff, sizeof(buff), c->allocator);
+    help_usage_print(&sink, c, c->state);
+    sink_flush(&sink);
+}
+
+
+void
+earg_help_print(FILE *file, const struct earg *c) {
+    char buff[CONFIG_EARG_SINK_BUFFSIZE];
+    struct earg_sink sink;
+
+    sink_init(&sink, earg_sink_file, file, buff, sizeof(buff), c->allocator);
+    help_print(&sink, c, c->state);
+    sink_flush(&sink);
 }
@@ -0,0 +1,55 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef HELP_H_
+#define HELP_H_
+
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "earg.h"
+#include "state.h"
+
+
+/* Width of the option column, computed once per command by the plan. */
+int
+help_gapsize(const struct earg *c, const struct earg_command *cmd,
+        bool subcommand);
+
+
+#ifdef CONFIG_EARG_HELP_CACHE
+
+/* Render the help of the node except the usage lines into node->help. */
+int
+help_render(const struct earg *c, struct plannode *node);
+
+#endif
+
+
+void
+help_usage_print(struct earg_sink *sink, const struct earg *c,
+        struct earg_state *state);
+
+
+void
+help_print(struct earg_sink *sink, const struct earg *c,
+        struct earg_state *state);
+
+
+#endif  // HELP_H_
@@ -0,0 +1,50 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <string.h>
+
+#include "elog.h"
+
+
+enum elog_verbosity elog_verbosity = ELOG_INFO;
+
+
+static const char *_names[] = {
+    "silent", "fatal", "error", "warn", "info", "debug", NULL,
+};
+
+
+/* Accepts the full name, the first letter or the digit of the level */
+enum elog_verbosity
+elog_verbosity_from_string(const char *verbosity) {
+    int i;
+
+    if (verbosity == NULL) {
+        return ELOG_UNKNOWN;
+    }
+
+    for (i = 0; _names[i]; i++) {
+        if ((strcmp(verbosity, _names[i]) == 0) ||
+                ((verbosity[0] == _names[i][0]) && (verbosity[1] == 0)) ||
+                ((verbosity[0] == ('0' + i)) && (verbosity[1] == 0))) {
+            return i;
+        }
+    }
+
+    return ELOG_UNKNOWN;
+}
@@ -0,0 +1,42 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef ELOG_H_
+#define ELOG_H_
+
+
+/* Minimal stand-in for the elog component, for the host build only. */
+enum elog_verbosity {
+    ELOG_UNKNOWN = -1,
+    ELOG_SILENT = 0,
+    ELOG_FATAL = 1,
+    ELOG_ERROR = 2,
+    ELOG_WARNING = 3,
+    ELOG_INFO = 4,
+    ELOG_DEBUG = 5,
+};
+
+
+extern enum elog_verbosity elog_verbosity;
+
+
+enum elog_verbosity
+elog_verbosity_from_string(const char *verbosity);
+
+
+#endif  // ELOG_H_
@@ -21,7 +21,10 @@
 
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <sys/types.h>
 
 
 #ifdef __clang__
@@ -57,6 +60,20 @@ enum earg_flags{
     EARG_NOHELP = 1,
     EARG_NOUSAGE = 2,
     EARG_NOELOG = 4,
+
+    /* accept unique prefixes of long options and sub-commands, like
+     * --verb=debug or net co */
+    EARG_ABBREV = 8,
+
+    /* options are visible to the sub-commands only if they are flagged
+     * with EARG_OPTION_INHERITED, builtins always are */
+    EARG_SCOPED = 16,
+
+    /* @path arguments are replaced by the ones stored in the file, split
+     * like earg_parse_line() does, requires a non-zero
+     * CONFIG_EARG_RESPONSEFILE_DEPTH. The values handed to the eaters
+     * point into the file, valid until the parse returns. */
+    EARG_RESPONSEFILE = 32,
 };
 
 
@@ -73,6 +90,36 @@ typedef int (*earg_entrypoint_t) (const struct earg *c,
 enum earg_optionflags {
     EARG_OPTION_NONE = 0,
     EARG_OPTION_MULTIPLE = 1,
+
+    /* global option, accepted after the sub-commands too, see EARG_SCOPED.
+     * Sub-commands may shadow it by an option of the same name or key. */
+    EARG_OPTION_INHERITED = 2,
+};
+
+
+/* Typed options are converted and stored at the command's userptr +
+ * offset, the eater is not called for them. */
+enum earg_optiontype {
+    EARG_TYPE_NONE = 0,
+
+    /* int, decimal or 0x prefixed hex */
+    EARG_TYPE_INT,
+
+    /* unsigned int */
+    EARG_TYPE_UINT,
+
+    /* float */
+    EARG_TYPE_FLOAT,
+
+    /* bool, flags are set to true, values are one of: 1|0, true|false,
+     * yes|no and on|off */
+    EARG_TYPE_BOOL,
+
+    /* size_t, with optional k, M or G suffix */
+    EARG_TYPE_SIZE,
+
+    /* int, index of the value in the choices */
+    EARG_TYPE_ENUM,
 };
 
 
@@ -83,6 +130,11 @@ struct earg_option {
     const char *arg;
     enum earg_optionflags flags;
     const char *help;
+
+    /* typed binding */
+    enum earg_optiontype type;
+    size_t offset;
+    const char * const * _Nullable choices;
 };
 
 
@@ -91,32 +143,387 @@ struct earg_command {
     const char *name;
     const struct earg_option * _Nullable options;
     const struct earg_command ** _Nullable commands;
+
+    /* positionals, e.g. "NAME [VALUE]" or "FILE...", each line of a
+     * multi-line hint is an alternative and the count must match one of
+     * them */
     const char *args;
     const char *header;
     const char *footer;
     earg_eater_t eat;
     void *userptr;
     earg_entrypoint_t entrypoint;
+
+    /* NULL terminated list of alternative names */
+    const char * const * _Nullable aliases;
+};
+
+
+/* Heap hooks, ptr of the allocator is handed to each call. */
+typedef void *(*earg_malloc_t)(void *ptr, size_t size);
+typedef void *(*earg_realloc_t)(void *ptr, void *mem, size_t size);
+typedef void (*earg_free_t)(void *ptr, void *mem);
+struct earg_allocator {
+    earg_malloc_t malloc;
+    earg_realloc_t realloc;
+    earg_free_t free;
+    void *ptr;
+};
+
+
+/* Output sink, the text is assembled in buff and handed to write once
+ * the buffer is full or the message is complete. */
+typedef int (*earg_write_t)(void *ptr, const char *data, size_t len);
+struct earg_sink {
+    earg_write_t write;
+    void *ptr;
+    char *buff;
+    size_t size;
+    size_t len;
+
+    /* the tree's, set while parsing, a message larger than buff is
+     * formatted on this heap */
+    const struct earg_allocator * _Nullable allocator;
 };
 
 
 typedef struct earg_state *earg_state_t;
+typedef struct earg_plan *earg_plan_t;
 struct earg {
     struct earg_command;
 
     const char *version;
     enum earg_flags flags;
 
+    /* everything allocated for the tree, the plan and the states goes
+     * through this, NULL for the global one, see earg_allocator_set() */
+    const struct earg_allocator * _Nullable allocator;
+
+    /* Environment defaults, e.g. "FOO_". FOO_DRY_RUN=yes stands for
+     * --dry-run when the option, visible to the final command, is not
+     * given on the command line. Flags are given by 1|0, true|false,
+     * yes|no or on|off. The environment is scanned once, after the
+     * command line, so the eaters see each option at most once. */
+    const char * _Nullable envprefix;
+
+    /* Config file, lowest in precedence, below the environment. Entries
+     * are long option names, with or without a value, and [sub.command]
+     * sections hold the options of the sub-commands. Only the sections on
+     * the parsed command chain are read. It's opened after the command
+     * line, so an eater may set it, and a missing file is ignored. The
+     * values point into the file, valid until the parse returns. */
+    const char * _Nullable configfile;
+
+    /* help texts are compressed against it, set by tools/earggen.py
+     * --compress, see CONFIG_EARG_HELP_COMPRESS */
+    const char * const * _Nullable dictionary;
+
     /* Internal earg state */
     earg_state_t state;
+    earg_plan_t plan;
+};
+
+
+/* Allocator of the trees without one, NULL restores malloc() and free().
+ * It must be set before the first allocation, and the transient buffers
+ * which don't belong to a tree use it too. */
+void
+earg_allocator_set(const struct earg_allocator * _Nullable allocator);
+
+
+/* Accounting allocator, passes each call to the backend, NULL for
+ * malloc(), and counts the bytes. Blocks are prefixed by their size, so
+ * it must see the whole life of the blocks. Counters are atomic, the
+ * allocator may be shared by threads. */
+struct earg_countingallocator {
+    struct earg_allocator;
+    const struct earg_allocator * _Nullable backend;
+
+    /* bytes and calls, so far */
+    size_t total;
+    size_t allocs;
+
+    /* bytes in use, now and the highest */
+    size_t current;
+    size_t peak;
 };
 
 
+const struct earg_allocator *
+earg_countingallocator_init(struct earg_countingallocator *a,
+        const struct earg_allocator * _Nullable backend);
+
+
+/* Validate the whole command tree once and freeze it into a read-only
+ * plan. earg_parse() uses the plan instead of rebuilding the option
+ * tables on each call. The tree, flags and version must not be changed
+ * afterwards. Trees generated by tools/earggen.py come with a plan in
+ * rodata, there is nothing to compile for them. */
+int
+earg_compile(struct earg *c);
+
+
+void
+earg_plan_dispose(struct earg *c);
+
+
+/* Worst case memory needs of a tree, over all of its command paths. */
+struct earg_footprint {
+    /* the lowest CONFIG_EARG_OPTIONS_MAX and CONFIG_EARG_CMDSTACK_MAX
+     * the tree fits in, builtin options and the root command included */
+    size_t options;
+    size_t depth;
+
+    /* bytes of a parser state with the configured limits, and about the
+     * same with the lowest limits above, see earg_state_size() */
+    size_t state;
+    size_t statemin;
+
+    /* the tokenizer, part of the state */
+    size_t tokenizer;
+
+    /* heap bytes of the plan earg_compile() builds, the cached help
+     * excluded, and the option tables and indexes among them */
+    size_t plan;
+    size_t optiondb;
+};
+
+
+/* Walk the tree without compiling it. Returns 0, or -1 if the tree
+ * doesn't fit in the configured limits, the footprint is filled anyway.
+ * The parser is iterative, its stack usage doesn't depend on the tree. */
+int
+earg_footprint(const struct earg *c, struct earg_footprint *f);
+
+
+/* The tree is compiled on the first call if earg_compile() is not called,
+ * both the compiled tree and the state are kept until earg_dispose().
+ * With CONFIG_EARG_STATE_STATIC there is a single state, it belongs to
+ * the first tree parsed until that tree is disposed, and the other trees
+ * fail with EARG_FATAL meanwhile. earg_parse() is not reentrant, use
+ * earg_parse_r() for that. */
 enum earg_status
 earg_parse(struct earg *c, int argc, const char **argv,
         const struct earg_command **command);
 
 
+/* Size of the caller supplied buffer required by earg_state_init(). */
+size_t
+earg_state_size();
+
+
+/* Place a parser state into the given buffer, the buffer must be aligned
+ * for a pointer and at least earg_state_size() bytes. returns NULL on
+ * failure. */
+earg_state_t
+earg_state_init(void *buff, size_t size);
+
+
+void
+earg_state_reset(earg_state_t state);
+
+
+/* Heap-free and reentrant variant of earg_parse(). The tree must be
+ * compiled using earg_compile() and the whole parse is done inside the
+ * given state, so multiple threads may parse against the same tree, each
+ * one with its own state. */
+enum earg_status
+earg_parse_r(const struct earg *c, earg_state_t state, int argc,
+        const char **argv, const struct earg_command **command);
+
+
+/* Same as earg_parse_r() but splits the given line into arguments in
+ * place, honouring single and double quotes, backslash escapes and runs
+ * of whitespace. The first word is the program name. The line is
+ * modified and the arguments handed to the eaters point into it. */
+enum earg_status
+earg_parse_line(const struct earg *c, earg_state_t state, char *line,
+        const struct earg_command **command);
+
+
+/* Incremental parsing for slow links. Bytes given to earg_feed() are
+ * appended to the buffer and each argument is resolved, and eaten, as
+ * soon as it's complete, earg_feed_end() finishes the parse at the end
+ * of the line. earg_feed() returns early with the error if the line is
+ * already known to be invalid. */
+int
+earg_feed_begin(const struct earg *c, earg_state_t state, char *buff,
+        size_t size);
+
+
+enum earg_status
+earg_feed(earg_state_t state, const char *bytes, size_t n);
+
+
+enum earg_status
+earg_feed_end(earg_state_t state, const struct earg_command **command);
+
+
+/* Result of a single line of earg_parse_batch() */
+struct earg_batchresult {
+    size_t line;
+    enum earg_status status;
+    const struct earg_command *command;
+
+    /* elog verbosity requested by the line, -1 if not changed, it's not
+     * applied, see earg_state_verbosity() */
+    int verbosity;
+};
+
+
+/* Parse each line of the NUL terminated buffer against the compiled tree
+ * using the given number of threads, the buffer is modified in place.
+ * Each line is a whole command line, the program name first. Results,
+ * output and diagnostics are reported in the input order. Returns the
+ * number of lines, or -1 on failure or if count is too small. If results
+ * is NULL, only the number of lines is returned.
+ *
+ * The eaters are called from the worker threads, concurrently and in no
+ * particular order across the lines. They must be thread-safe and must
+ * not write through the shared userptr, for the same reason typed
+ * options, which are stored there, must not be used.
+ *
+ * The environment and the config file are read once, before the first
+ * line, and shared by all of them. The verbosity options don't change
+ * elog_verbosity, each line reports its own in the result. */
+ssize_t
+earg_parse_batch(const struct earg *c, char *buff,
+        struct earg_batchresult *results, size_t count, int workers);
+
+
+/* Same as earg_parse_batch() over the lines of a file. The file is
+ * mapped private, or read once if mmap() is not available, and the values
+ * handed to the eaters point into it, valid until the call returns. */
+ssize_t
+earg_parse_batchfile(const struct earg *c, const char *path,
+        struct earg_batchresult *results, size_t count, int workers);
+
+
+/* earg_complete() candidate */
+enum earg_candidatetype {
+    /* long option, the name is without the leading dashes */
+    EARG_CANDIDATE_OPTION,
+
+    /* sub-command name or alias */
+    EARG_CANDIDATE_COMMAND,
+
+    /* value of an EARG_TYPE_ENUM option */
+    EARG_CANDIDATE_CHOICE,
+};
+
+
+struct earg_candidate {
+    enum earg_candidatetype type;
+    const char *name;
+};
+
+
+/* Completion candidates for the word under the cursor, only the first
+ * cursor bytes of the line are read. The caller replaces the bytes from
+ * *start up to the cursor with the candidate, preceded by "--" for
+ * options. Long options are offered for the words starting with a dash,
+ * enum values after an option which takes them and sub-commands for the
+ * rest. Candidates come in the name order of each lookup table, the
+ * options of the inner command first. Returns the number of candidates,
+ * only the first count are stored, or -1 on failure. The tree must be
+ * compiled using earg_compile(). Lines up to about half of
+ * CONFIG_EARG_COMPLETE_BUFFSIZE are completed without heap. */
+ssize_t
+earg_complete(const struct earg *c, const char *line, size_t cursor,
+        size_t *start, struct earg_candidate *candidates, size_t count);
+
+
+/* Counters of a single parse, filled only when CONFIG_EARG_STATS is
+ * enabled. */
+struct earg_stats {
+    /* arguments and short options classified by the tokenizer */
+    unsigned int tokens;
+
+    /* option table lookups, by name, key or prefix */
+    unsigned int probes;
+
+    /* sub-command dispatch table lookups */
+    unsigned int lookups;
+
+    /* eat callback invocations and the time spent in them */
+    unsigned int eats;
+    uint64_t eatns;
+
+    /* the state and the compiled tree, when earg_parse() allocates them */
+    size_t heap;
+
+    /* length of the command chain, the program included */
+    unsigned int depth;
+
+    /* the whole parse, for earg_feed() it's from earg_feed_begin() to
+     * earg_feed_end() */
+    uint64_t ns;
+
+    /* the last command of the chain, NULL if not even the program name is
+     * read */
+    const struct earg_command *command;
+};
+
+
+/* Sums over many parses, see earg_state_aggregate(). */
+struct earg_statsaggregate {
+    unsigned long calls;
+
+    /* parses finished with EARG_USERERROR or EARG_FATAL */
+    unsigned long failures;
+
+    /* sums of the counters, except the depth which is the deepest, the
+     * command is not used */
+    struct earg_stats total;
+
+    /* the slowest parse */
+    struct earg_stats slowest;
+};
+
+
+/* Counters of the last parse, NULL if CONFIG_EARG_STATS is disabled. Use
+ * earg->state for earg_parse(). */
+const struct earg_stats *
+earg_state_stats(earg_state_t state);
+
+
+/* Accumulate the counters of each next parse of the state into the given
+ * aggregate, NULL stops it. The aggregate is not locked, use one per state
+ * when parsing on multiple threads. Returns -1 if CONFIG_EARG_STATS is
+ * disabled. */
+int
+earg_state_aggregate(earg_state_t state,
+        struct earg_statsaggregate *aggregate);
+
+
+/* elog verbosity requested by the last parse, -1 if not changed. It's
+ * stored to elog_verbosity at once when the parse succeeds. */
+int
+earg_state_verbosity(earg_state_t state);
+
+
+int
+earg_state_try_help(earg_state_t state);
+
+
+/* earg_write_t over a FILE *, the default sinks use it with stdout and
+ * stderr. */
+int
+earg_sink_file(void *file, const char *data, size_t len);
+
+
+/* Send the output (help, usage and version) and the diagnostics of the
+ * state to the given sinks, NULL keeps the current one. Sinks without a
+ * buffer use the one inside the state. */
+void
+earg_state_sinks(earg_state_t state, const struct earg_sink *out,
+        const struct earg_sink *err);
+
+
+int
+earg_state_commandchain_print(FILE *file, earg_state_t state);
+
+
 int
 earg_dispose(struct earg *c);
 
@@ -20,16 +20,17 @@
 
 #include "toolbox.h"
 #include "earg.h"
+#include "sink.h"
 #include "option.h"
 
 
 int
-option_print(FILE *file, const struct earg_option *opt) {
+option_print(struct earg_sink *sink, const struct earg_option *opt) {
     int bytes = 0;
     int status;
 
     if ((opt->key != 0) && ISCHAR(opt->key)) {
-        status = fprintf(file, "-%c%s", opt->key, opt->name? "/": "");
+        status = sink_printf(sink, "-%c%s", opt->key, opt->name? "/": "");
         if (status == -1) {
             return -1;
         }
@@ -38,7 +39,7 @@ option_print(FILE *file, const struct earg_option *opt) {
     }
 
     if (opt->name) {
-        status = fprintf(file, "--%s", opt->name);
+        status = sink_printf(sink, "--%s", opt->name);
         if (status == -1) {
             return -1;
         }
@@ -22,58 +22,181 @@
 #include <unistd.h>
 
 #include "toolbox.h"
+#include "allocator.h"
+#include "hash.h"
 #include "option.h"
 #include "optiondb.h"
+#include "prefix.h"
 
 
-#define EXTENDSIZE 8
+/* Smaller tables are scanned, that's as fast as hashing */
+#define INDEX_MINOPTIONS 4
 
 
-int
-optiondb_extend(struct optiondb *db) {
-    struct optioninfo *new;
-    size_t newsize = db->size + EXTENDSIZE;
+#ifdef CONFIG_EARG_OPTIONDB_INDEX
 
-    if (newsize > CONFIG_EARG_OPTIONS_MAX) {
-        newsize = CONFIG_EARG_OPTIONS_MAX;
-    }
+/* keep the load factor at most 50% */
+static unsigned int
+_index_slots(size_t options) {
+    unsigned int size = 2;
 
-    if (newsize <= db->size) {
-        PERR("maximum allowed options are exceeded: %d\n",
-                CONFIG_EARG_OPTIONS_MAX);
-        return -1;
+    while (size < (options * 2)) {
+        size <<= 1;
     }
 
-    new = realloc(db->repo, newsize * sizeof(struct optioninfo));
+    return size;
+}
+
 
-    if (new == NULL) {
+static int
+_index_init(struct optiondb *db, const struct earg_allocator *a) {
+    unsigned int size = _index_slots(db->size);
+
+    db->index = allocator_calloc(a, 1, sizeof(struct optionindex) + size);
+    if (db->index == NULL) {
         return -1;
     }
 
-    db->repo = new;
-    db->size = newsize;
+    db->index->mask = size - 1;
+    db->index->seed = HASH_FNV1A_BASIS;
     return 0;
 }
 
 
-int
-optiondb_exists(struct optiondb *db, const struct earg_option *opt) {
+static void
+_index_insert(struct optionindex *index, const struct optioninfo *info,
+        unsigned char slot) {
+    unsigned int h;
+    const struct earg_option *opt = info->option;
+
+    if ((opt->key > 0) && (opt->key < 256)) {
+        index->keys[opt->key] = slot;
+    }
+
+    if (opt->name == NULL) {
+        return;
+    }
+
+    h = hash_fnv1a(index->seed, opt->name, info->namelen) & index->mask;
+    while (index->names[h]) {
+        h = (h + 1) & index->mask;
+    }
+    index->names[h] = slot;
+}
+
+#endif
+
+
+static const struct optioninfo *
+_findbyname(const struct optiondb *db, const char *name, int len) {
     int i;
     const struct optioninfo *info;
+#ifdef CONFIG_EARG_OPTIONDB_INDEX
+    unsigned int h;
+    unsigned char slot;
+
+    if (db->index) {
+        h = hash_fnv1a(db->index->seed, name, len) & db->index->mask;
+        while ((slot = db->index->names[h])) {
+            info = db->repo + slot - 1;
+            if ((info->namelen == len) &&
+                    STRNEQ(name, info->option->name, len)) {
+                return info;
+            }
+            h = (h + 1) & db->index->mask;
+        }
+
+        return NULL;
+    }
+#endif
 
     for (i = 0; i < db->count; i++) {
         info = db->repo + i;
-        if (((info->option->key == opt->key) ||
-                 (info->option->name && opt->name &&
-                  STREQ(info->option->name, opt->name)))) {
-            return 1;
+
+        if (info->option->name == NULL) {
+            continue;
+        }
+
+        if ((info->namelen == len) && STRNEQ(name, info->option->name, len)) {
+            return info;
         }
     }
 
+    return NULL;
+}
+
+
+static const struct optioninfo *
+_findbykey(const struct optiondb *db, int key) {
+    int i;
+    const struct optioninfo *info;
+#ifdef CONFIG_EARG_OPTIONDB_INDEX
+    unsigned char slot;
+
+    /* builtin and non-ascii keys are out of the direct-mapped table */
+    if (db->index && (key > 0) && (key < 256)) {
+        slot = db->index->keys[key];
+        return slot? db->repo + slot - 1: NULL;
+    }
+#endif
+
+    for (i = 0; i < db->count; i++) {
+        info = db->repo + i;
+
+        if (info->option->key == key) {
+            return info;
+        }
+    }
+
+    return NULL;
+}
+
+
+static const char *
+_sortedname(const void *table, int i) {
+    const struct optiondb *db = table;
+
+    return db->repo[db->sorted[i]].option->name;
+}
+
+
+/* Options of this db, not the parents', whose names start with the
+ * prefix are db->sorted[*first] ... db->sorted[*first + count - 1]. */
+int
+optiondb_prefixsearch(const struct optiondb *db, const char *prefix,
+        int len, int *first) {
+    return prefix_search(db, db->sortedcount, _sortedname, prefix, len,
+            first);
+}
+
+
+/* In this db only, the parents' ones are shadowed */
+int
+optiondb_exists(const struct optiondb *db, const struct earg_option *opt) {
+    if (_findbykey(db, opt->key)) {
+        return 1;
+    }
+
+    if (opt->name && _findbyname(db, opt->name, strlen(opt->name))) {
+        return 1;
+    }
+
     return 0;
 }
 
 
+/* The info is reachable from db, it's not shadowed nor hidden */
+bool
+optiondb_visible(const struct optiondb *db, const struct optioninfo *info) {
+    if (info->option->name) {
+        return optiondb_findbyname(db, info->option->name, info->namelen) ==
+            info;
+    }
+
+    return optiondb_findbykey(db, info->option->key) == info;
+}
+
+
 int
 optiondb_insert(struct optiondb *db, const struct earg_option *opt,
         const struct earg_command *command) {
@@ -81,21 +204,43 @@ optiondb_insert(struct optiondb *db, const struct earg_option *opt,
 
     /* check existance */
     if (optiondb_exists(db, opt)) {
-        PERR("option duplicated -- '");
-        option_print(stderr, opt);
-        PERR("'\n");
+        if (opt->name == NULL) {
+            PERR("option duplicated -- '-%c'\n", opt->key);
+        }
+        else if (opt->key && ISCHAR(opt->key)) {
+            PERR("option duplicated -- '-%c/--%s'\n", opt->key, opt->name);
+        }
+        else {
+            PERR("option duplicated -- '--%s'\n", opt->name);
+        }
         return -1;
     }
 
-    /* extend db if there is no space for new item */
-    if ((db->count == db->size) && optiondb_extend(db)) {
+    if ((db->base + db->count) >= CONFIG_EARG_OPTIONS_MAX) {
+        PERR("maximum allowed options are exceeded: %d\n",
+                CONFIG_EARG_OPTIONS_MAX);
         return -1;
     }
 
-    info = db->repo + (db->count++);
+    if (db->count == db->size) {
+        return -1;
+    }
+
+    info = db->repo + db->count;
     info->option = opt;
     info->command = command;
-    info->occurances = 0;
+    info->namelen = opt->name? strlen(opt->name): 0;
+    info->id = db->base + db->count;
+    info->builtin = 0;
+    info->inherited = true;
+    info->choices = NULL;
+    db->count++;
+
+#ifdef CONFIG_EARG_OPTIONDB_INDEX
+    if (db->index) {
+        _index_insert(db->index, info, db->count);
+    }
+#endif
     return 0;
 }
 
@@ -119,51 +264,111 @@ optiondb_insertvector(struct optiondb *db, const struct earg_option *opt,
 }
 
 
+/* Insertion sort, tables are small and it's done once per compile. */
 int
-optiondb_init(struct optiondb *db) {
-    db->repo = calloc(EXTENDSIZE, sizeof(struct optioninfo));
-    if (db->repo == NULL) {
+optiondb_sort(struct optiondb *db, const struct earg_allocator *a) {
+    int i;
+    int j;
+    int count = 0;
+    unsigned char *sorted;
+    const char *name;
+
+    if (db->count == 0) {
+        return 0;
+    }
+
+    sorted = allocator_malloc(a, db->count);
+    if (sorted == NULL) {
         return -1;
     }
-    db->size = EXTENDSIZE;
+
+    for (i = 0; i < db->count; i++) {
+        name = db->repo[i].option->name;
+        if (name == NULL) {
+            continue;
+        }
+
+        for (j = count++; (j > 0) && (strcmp(name,
+                        db->repo[sorted[j - 1]].option->name) < 0); j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = i;
+    }
+
+    db->sorted = sorted;
+    db->sortedcount = count;
+    return 0;
+}
+
+
+int
+optiondb_init(struct optiondb *db, struct optioninfo *repo, size_t size,
+        const struct optiondb *parent, const struct earg_allocator *a) {
+    db->parent = parent;
+    db->repo = repo;
+    db->size = size;
     db->count = 0;
+    db->base = parent? parent->base + parent->count: 0;
+    db->index = NULL;
+    db->sorted = NULL;
+    db->sortedcount = 0;
+
+#ifdef CONFIG_EARG_OPTIONDB_INDEX
+    if ((size >= INDEX_MINOPTIONS) && _index_init(db, a)) {
+        return -1;
+    }
+#endif
 
     return 0;
 }
 
 
+/* heap bytes of a db with the given number of options, the index and the
+ * sorted list */
+size_t
+optiondb_footprint(size_t size) {
+    size_t bytes = size;
+
+#ifdef CONFIG_EARG_OPTIONDB_INDEX
+    if (size >= INDEX_MINOPTIONS) {
+        bytes += sizeof(struct optionindex) + _index_slots(size);
+    }
+#endif
+
+    return bytes;
+}
+
+
 void
-optiondb_dispose(struct optiondb *db) {
-    if (db->repo) {
-        free(db->repo);
+optiondb_dispose(struct optiondb *db, const struct earg_allocator *a) {
+    if (db->index) {
+        allocator_free(a, db->index);
+        db->index = NULL;
+    }
+
+    if (db->sorted) {
+        allocator_free(a, (unsigned char *)db->sorted);
+        db->sorted = NULL;
+        db->sortedcount = 0;
     }
 
-    db->count = -1;
+    db->count = 0;
 }
 
 
-struct optioninfo *
+const struct optioninfo *
 optiondb_findbyname(const struct optiondb *db, const char *name,
         int len) {
-    int i;
-    struct optioninfo *info;
-    char tmp[len + 1];
+    const struct optioninfo *info;
+    bool own = true;
 
     if (name == NULL) {
         return NULL;
     }
 
-    strncpy(tmp, name, len);
-    tmp[len] = 0;
-
-    for (i = 0; i < db->count; i++) {
-        info = db->repo + i;
-
-        if (info->option->name == NULL) {
-            continue;
-        }
-
-        if (STREQ(tmp, info->option->name)) {
+    for (; db; db = db->parent, own = false) {
+        info = _findbyname(db, name, len);
+        if (info && (own || info->inherited)) {
             return info;
         }
     }
@@ -172,15 +377,42 @@ optiondb_findbyname(const struct optiondb *db, const char *name,
 }
 
 
-struct optioninfo *
-optiondb_findbykey(const struct optiondb *db, int key) {
+/* Unique prefix over the command path, count is set to the number of
+ * visible options starting with the prefix. */
+const struct optioninfo *
+optiondb_findbyprefix(const struct optiondb *db, const char *prefix,
+        int len, int *count) {
     int i;
-    struct optioninfo *info;
+    int first;
+    int n;
+    const struct optiondb *scope;
+    const struct optioninfo *info = NULL;
+    const struct optioninfo *candidate;
+
+    *count = 0;
+    for (scope = db; scope; scope = scope->parent) {
+        n = optiondb_prefixsearch(scope, prefix, len, &first);
+        for (i = first; i < (first + n); i++) {
+            candidate = scope->repo + scope->sorted[i];
+            if ((scope == db) || optiondb_visible(db, candidate)) {
+                info = candidate;
+                (*count)++;
+            }
+        }
+    }
 
-    for (i = 0; i < db->count; i++) {
-        info = db->repo + i;
+    return (*count == 1)? info: NULL;
+}
 
-        if (info->option->key == key) {
+
+const struct optioninfo *
+optiondb_findbykey(const struct optiondb *db, int key) {
+    const struct optioninfo *info;
+    bool own = true;
+
+    for (; db; db = db->parent, own = false) {
+        info = _findbykey(db, key);
+        if (info && (own || info->inherited)) {
             return info;
         }
     }
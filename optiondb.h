@@ -21,6 +21,7 @@
 
 
 #include <stddef.h>
+#include <stdbool.h>
 
 #include "earg.h"
 
@@ -34,23 +35,62 @@ enum optioninfoflag {
 struct optioninfo {
     const struct earg_option *option;
     const struct earg_command *command;
-    unsigned int occurances;
+    unsigned short namelen;
+
+    /* occurrence slot, unique over the command path */
+    unsigned char id;
+
+    /* enum builtin */
+    unsigned char builtin;
+
+    /* visible in the sub-commands, unless shadowed */
+    bool inherited;
+
+    /* EARG_TYPE_ENUM lookup table */
+    const struct choiceindex *choices;
 };
 
 
+struct choiceindex;
+
+
+/* Lookup tables, both store the repo offset + 1, zero means empty. */
+struct optionindex {
+    unsigned char keys[256];
+    unsigned int mask;
+    unsigned int seed;
+    unsigned char names[];
+};
+
+
+/* Options of a single command, a scope. Lookups fall through to the
+ * inherited options of the parents', the innermost wins. */
 struct optiondb {
+    const struct optiondb *parent;
     struct optioninfo *repo;
     size_t size;
-    volatile size_t count;
+    size_t count;
+    unsigned char base;
+    struct optionindex *index;
+
+    /* repo offsets of the named options ordered by name, for prefix
+     * lookups */
+    const unsigned char *sorted;
+    unsigned char sortedcount;
 };
 
 
 int
-optiondb_init(struct optiondb *db);
+optiondb_init(struct optiondb *db, struct optioninfo *repo, size_t size,
+        const struct optiondb *parent, const struct earg_allocator *a);
 
 
 void
-optiondb_dispose(struct optiondb *db);
+optiondb_dispose(struct optiondb *db, const struct earg_allocator *a);
+
+
+size_t
+optiondb_footprint(size_t size);
 
 
 int
@@ -64,15 +104,33 @@ optiondb_insertvector(struct optiondb *db, const struct earg_option *opt,
 
 
 int
-optiondb_exists(struct optiondb *db, const struct earg_option *opt);
+optiondb_sort(struct optiondb *db, const struct earg_allocator *a);
 
 
-struct optioninfo *
+int
+optiondb_exists(const struct optiondb *db, const struct earg_option *opt);
+
+
+bool
+optiondb_visible(const struct optiondb *db, const struct optioninfo *info);
+
+
+const struct optioninfo *
 optiondb_findbyname(const struct optiondb *db, const char *name,
         int len);
 
 
-struct optioninfo *
+int
+optiondb_prefixsearch(const struct optiondb *db, const char *prefix,
+        int len, int *first);
+
+
+const struct optioninfo *
+optiondb_findbyprefix(const struct optiondb *db, const char *prefix,
+        int len, int *count);
+
+
+const struct optioninfo *
 optiondb_findbykey(const struct optiondb *db, int key);
 
 
@@ -0,0 +1,574 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "toolbox.h"
+#include "allocator.h"
+#include "builtin.h"
+#include "arghint.h"
+#include "binding.h"
+#include "help.h"
+#include "optiondb.h"
+#include "plan.h"
+#include "prefix.h"
+
+
+static size_t
+_options_count(const struct earg_option *opt) {
+    size_t count = 0;
+
+    while (opt && opt->name) {
+        if (opt->key) {
+            count++;
+        }
+        opt++;
+    }
+
+    return count;
+}
+
+
+static size_t
+_builtins_count(const struct earg *c) {
+    size_t count = 0;
+
+    if (c->version) {
+        count++;
+    }
+
+    if (!HASFLAG(c, EARG_NOHELP)) {
+        count++;
+    }
+
+    if (!HASFLAG(c, EARG_NOUSAGE)) {
+        count++;
+    }
+
+    if (!HASFLAG(c, EARG_NOELOG)) {
+        count += 3;
+    }
+
+    return count;
+}
+
+
+static size_t
+_children_count(const struct earg_command *cmd) {
+    size_t count = 0;
+    const struct earg_command **c = cmd->commands;
+
+    while (c && *c) {
+        count++;
+        c++;
+    }
+
+    return count;
+}
+
+
+static size_t
+_aliases_count(const struct earg_command *cmd) {
+    size_t count = 0;
+    const char * const *a = cmd->aliases;
+
+    while (a && *a) {
+        count++;
+        a++;
+    }
+
+    return count;
+}
+
+
+static int
+_count(struct earg_plan *plan, const struct earg_command *cmd, int depth) {
+    const struct earg_command **c = cmd->commands;
+
+    if (depth > CONFIG_EARG_CMDSTACK_MAX) {
+        PERR("maximum allowed command chain length is exceeded: %d\n",
+                CONFIG_EARG_CMDSTACK_MAX);
+        return -1;
+    }
+
+    plan->nodescount++;
+    plan->infoscount += _options_count(cmd->options);
+    if (depth > 1) {
+        plan->entriescount += _aliases_count(cmd) + 1;
+    }
+
+    while (c && *c) {
+        if (_count(plan, *c, depth + 1)) {
+            return -1;
+        }
+        c++;
+    }
+
+    return 0;
+}
+
+
+static int
+_builtin_insert(struct optiondb *db, const struct earg_option *opt,
+        const struct earg *c, enum builtin builtin) {
+    if (optiondb_insert(db, opt, (struct earg_command *)c)) {
+        return -1;
+    }
+
+    db->repo[db->count - 1].builtin = builtin;
+    return 0;
+}
+
+
+static int
+_builtins_insert(struct optiondb *db, const struct earg *c) {
+    if (c->version && _builtin_insert(db, &opt_version, c,
+                BUILTIN_VERSION)) {
+        return -1;
+    }
+
+    if ((!HASFLAG(c, EARG_NOHELP)) && _builtin_insert(db, &opt_help, c,
+                BUILTIN_HELP)) {
+        return -1;
+    }
+
+    if ((!HASFLAG(c, EARG_NOUSAGE)) && _builtin_insert(db, &opt_usage, c,
+                BUILTIN_USAGE)) {
+        return -1;
+    }
+
+    if (!HASFLAG(c, EARG_NOELOG)) {
+        if (_builtin_insert(db, &opt_verbosity, c, BUILTIN_VERBOSITY)) {
+            return -1;
+        }
+        if (_builtin_insert(db, &opt_verboseflag, c, BUILTIN_VERBOSER)) {
+            return -1;
+        }
+        if (_builtin_insert(db, &opt_quietflag, c, BUILTIN_QUIETER)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+static int
+_entrycmp(const void *a, const void *b) {
+    return strcmp(((const struct planentry *)a)->name,
+            ((const struct planentry *)b)->name);
+}
+
+
+static int
+_dispatch_build(struct plannode *node, struct planentry *entries) {
+    int i;
+    int count = 0;
+    const struct plannode *child;
+    const char * const *alias;
+
+    for (i = 0; i < node->childrencount; i++) {
+        child = node->children + i;
+        entries[count].name = child->command->name;
+        entries[count++].node = child;
+
+        for (alias = child->command->aliases; alias && *alias; alias++) {
+            entries[count].name = *alias;
+            entries[count++].node = child;
+        }
+    }
+
+    qsort(entries, count, sizeof(struct planentry), _entrycmp);
+    for (i = 1; i < count; i++) {
+        if (STREQ(entries[i - 1].name, entries[i].name)) {
+            PERR("command duplicated -- '%s'\n", entries[i].name);
+            return -1;
+        }
+    }
+
+    node->dispatch = entries;
+    node->dispatchcount = count;
+    return 0;
+}
+
+
+static int
+_node_build(struct earg_plan *plan, struct plannode *node,
+        const struct earg_command *cmd, const struct plannode *parent,
+        size_t *nodes, size_t *infos, size_t *entries, size_t builtins) {
+    int i;
+    size_t entriescount = 0;
+    size_t optcount = _options_count(cmd->options) + builtins;
+    struct plannode *children;
+    struct optioninfo *info;
+    const struct earg *root;
+
+    node->command = cmd;
+    node->parent = parent;
+    root = (const struct earg *)plan->nodes->command;
+    node->gapsize = help_gapsize(root, cmd, parent != NULL);
+    /* -1, the count of positionals is not validated */
+    node->arghint = arghint_parse(cmd->args);
+
+#ifdef CONFIG_EARG_HELP_CACHE
+    if (help_render(root, node)) {
+        return -1;
+    }
+#endif
+
+    if (optiondb_init(&node->optiondb, plan->infos + *infos, optcount,
+                parent? &parent->optiondb: NULL, plan->allocator)) {
+        return -1;
+    }
+    *infos += optcount;
+
+    if (builtins && _builtins_insert(&node->optiondb,
+                (const struct earg *)cmd)) {
+        return -1;
+    }
+
+    if (optiondb_insertvector(&node->optiondb, cmd->options, cmd)) {
+        return -1;
+    }
+
+    if (optiondb_sort(&node->optiondb, plan->allocator)) {
+        return -1;
+    }
+
+    for (i = 0; i < node->optiondb.count; i++) {
+        info = node->optiondb.repo + i;
+        info->inherited = info->builtin || (!HASFLAG(root, EARG_SCOPED)) ||
+            HASFLAG(info->option, EARG_OPTION_INHERITED);
+
+        if (binding_compile(info, plan->allocator)) {
+            return -1;
+        }
+    }
+
+    /* reserve a contiguous block for the children */
+    node->childrencount = _children_count(cmd);
+    children = plan->nodes + *nodes;
+    node->children = children;
+    *nodes += node->childrencount;
+
+    for (i = 0; i < node->childrencount; i++) {
+        if (cmd->commands[i]->name == NULL) {
+            PERR("command without name\n");
+            return -1;
+        }
+
+        if (_node_build(plan, children + i, cmd->commands[i], node, nodes,
+                    infos, entries, 0)) {
+            return -1;
+        }
+        entriescount += _aliases_count(cmd->commands[i]) + 1;
+    }
+
+    if (node->childrencount == 0) {
+        return 0;
+    }
+
+    *entries += entriescount;
+    return _dispatch_build(node, plan->entries + *entries - entriescount);
+}
+
+
+static size_t
+_size(const struct earg_plan *plan) {
+    int i;
+    size_t size = sizeof(struct earg_plan) +
+        plan->nodescount * sizeof(struct plannode) +
+        MAX(plan->infoscount, 1) * sizeof(struct optioninfo) +
+        MAX(plan->entriescount, 1) * sizeof(struct planentry);
+    const struct optiondb *db;
+    const struct choiceindex *choices;
+
+    for (i = 0; i < plan->nodescount; i++) {
+        db = &plan->nodes[i].optiondb;
+        if (db->index) {
+            size += sizeof(struct optionindex) + db->index->mask + 1;
+        }
+
+        if (db->sorted) {
+            size += db->count;
+        }
+
+#ifdef CONFIG_EARG_HELP_CACHE
+        size += plan->nodes[i].helplen;
+#endif
+    }
+
+    for (i = 0; i < plan->infoscount; i++) {
+        choices = plan->infos[i].choices;
+        if (choices) {
+            size += sizeof(struct choiceindex) + choices->mask + 1 +
+                choices->count;
+        }
+    }
+
+    return size;
+}
+
+
+int
+plan_compile(struct earg_plan **out, const struct earg *c) {
+    struct earg_plan *plan;
+    size_t builtins = _builtins_count(c);
+    size_t nodes = 1;
+    size_t infos = 0;
+    size_t entries = 0;
+
+    plan = allocator_calloc(c->allocator, 1, sizeof(struct earg_plan));
+    if (plan == NULL) {
+        return -1;
+    }
+    plan->allocator = c->allocator;
+
+    if (_count(plan, (const struct earg_command *)c, 1)) {
+        goto failed;
+    }
+
+    plan->infoscount += builtins;
+    plan->nodes = allocator_calloc(plan->allocator, plan->nodescount,
+            sizeof(struct plannode));
+    plan->infos = allocator_calloc(plan->allocator,
+            plan->infoscount? plan->infoscount: 1, sizeof(struct optioninfo));
+    plan->entries = allocator_calloc(plan->allocator,
+            plan->entriescount? plan->entriescount: 1,
+            sizeof(struct planentry));
+    if ((plan->nodes == NULL) || (plan->infos == NULL) ||
+            (plan->entries == NULL)) {
+        goto failed;
+    }
+
+    if (_node_build(plan, plan->nodes, (const struct earg_command *)c, NULL,
+                &nodes, &infos, &entries, builtins)) {
+        goto failed;
+    }
+
+    plan->size = _size(plan);
+    *out = plan;
+    return 0;
+
+failed:
+    plan_dispose(plan);
+    return -1;
+}
+
+
+void
+plan_dispose(struct earg_plan *plan) {
+    int i;
+    const struct earg_allocator *a;
+
+    if ((plan == NULL) || plan->rodata) {
+        return;
+    }
+
+    a = plan->allocator;
+    if (plan->nodes) {
+        for (i = 0; i < plan->nodescount; i++) {
+            optiondb_dispose(&plan->nodes[i].optiondb, a);
+#ifdef CONFIG_EARG_HELP_CACHE
+            allocator_free(a, (char *)plan->nodes[i].help);
+#endif
+        }
+        allocator_free(a, plan->nodes);
+    }
+
+    if (plan->infos) {
+        for (i = 0; i < plan->infoscount; i++) {
+            binding_dispose(plan->infos + i, a);
+        }
+        allocator_free(a, plan->infos);
+    }
+
+    if (plan->entries) {
+        allocator_free(a, plan->entries);
+    }
+
+    allocator_free(a, plan);
+}
+
+
+/* Sums of the plan tables, the same as _count() but it goes on, without
+ * limits, to find the worst path. */
+static int
+_footprint(struct earg_footprint *f, struct earg_plan *plan,
+        const struct earg_command *cmd, size_t base, size_t builtins,
+        int depth) {
+    size_t count = _options_count(cmd->options) + builtins;
+    const struct earg_option *opt;
+    const struct earg_command **c;
+
+    /* cycles */
+    if (depth > UCHAR_MAX) {
+        return -1;
+    }
+
+    f->depth = MAX(f->depth, depth);
+    f->options = MAX(f->options, base + count);
+    f->optiondb += optiondb_footprint(count);
+    f->plan += optiondb_footprint(count);
+
+    plan->nodescount++;
+    plan->infoscount += count;
+    if (depth > 1) {
+        plan->entriescount += _aliases_count(cmd) + 1;
+    }
+
+    for (opt = cmd->options; opt && opt->name; opt++) {
+        if (opt->key) {
+            f->plan += binding_footprint(opt);
+        }
+    }
+
+    for (c = cmd->commands; c && *c; c++) {
+        if (_footprint(f, plan, *c, base + count, 0, depth + 1)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+int
+plan_footprint(const struct earg *c, struct earg_footprint *f) {
+    size_t infos;
+    struct earg_plan plan;
+
+    memset(&plan, 0, sizeof(plan));
+    if (_footprint(f, &plan, (const struct earg_command *)c, 0,
+                _builtins_count(c), 1)) {
+        return -1;
+    }
+
+    infos = MAX(plan.infoscount, 1) * sizeof(struct optioninfo);
+    f->optiondb += infos;
+    f->plan += sizeof(struct earg_plan) + infos +
+        plan.nodescount * sizeof(struct plannode) +
+        MAX(plan.entriescount, 1) * sizeof(struct planentry);
+    return 0;
+}
+
+
+const struct plannode *
+plan_findchild(const struct plannode *node, const char *name) {
+    int cmp;
+    int mid;
+    int lo = 0;
+    int hi = node->dispatchcount - 1;
+
+    if (name == NULL) {
+        return NULL;
+    }
+
+    while (lo <= hi) {
+        mid = (lo + hi) / 2;
+        cmp = strcmp(name, node->dispatch[mid].name);
+        if (cmp == 0) {
+            return node->dispatch[mid].node;
+        }
+
+        if (cmp < 0) {
+            hi = mid - 1;
+        }
+        else {
+            lo = mid + 1;
+        }
+    }
+
+    return NULL;
+}
+
+
+static const char *
+_entryname(const void *table, int i) {
+    const struct plannode *node = table;
+
+    return node->dispatch[i].name;
+}
+
+
+/* Names and aliases of the children starting with the prefix are
+ * node->dispatch[*first] ... node->dispatch[*first + count - 1]. */
+int
+plan_prefixsearch(const struct plannode *node, const char *prefix,
+        int *first) {
+    return prefix_search(node, node->dispatchcount, _entryname, prefix,
+            strlen(prefix), first);
+}
+
+
+/* Unique prefix of a child's name or aliases, count is set to the number
+ * of names starting with the prefix, or 1 if they all belong to the same
+ * child. */
+const struct plannode *
+plan_findchildbyprefix(const struct plannode *node, const char *prefix,
+        int *count) {
+    int i;
+    int first;
+    const struct plannode *child;
+
+    *count = plan_prefixsearch(node, prefix, &first);
+    if (*count == 0) {
+        return NULL;
+    }
+
+    child = node->dispatch[first].node;
+    for (i = first + 1; i < (first + *count); i++) {
+        if (node->dispatch[i].node != child) {
+            return NULL;
+        }
+    }
+
+    *count = 1;
+    return child;
+}
+
+
+/* Whether node->dispatch[i] stands for its child among the matches of
+ * plan_prefixsearch(), each child is listed once by its name, or by its
+ * first matching alias if the name does not match. */
+bool
+plan_prefixlisted(const struct plannode *node, int first, int count,
+        int i) {
+    int j;
+    const struct planentry *entry = node->dispatch + i;
+    const char *name = entry->node->command->name;
+
+    if (STREQ(entry->name, name)) {
+        return true;
+    }
+
+    for (j = first; j < (first + count); j++) {
+        if ((j == i) || (node->dispatch[j].node != entry->node)) {
+            continue;
+        }
+
+        if ((j < i) || STREQ(node->dispatch[j].name, name)) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,113 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef PLAN_H_
+#define PLAN_H_
+
+
+#include <stdbool.h>
+
+#include "earg.h"
+#include "optiondb.h"
+
+
+/* sub-command dispatch table entry, sorted by name */
+struct planentry {
+    const char *name;
+    const struct plannode *node;
+};
+
+
+struct plannode {
+    const struct earg_command *command;
+    const struct plannode *parent;
+    struct optiondb optiondb;
+    int arghint;
+
+    /* same order as command->commands */
+    const struct plannode *children;
+    unsigned short childrencount;
+
+    /* names and aliases of the children */
+    const struct planentry *dispatch;
+    unsigned short dispatchcount;
+
+    /* help layout */
+    unsigned short gapsize;
+
+#ifdef CONFIG_EARG_HELP_CACHE
+    /* rendered help, everything after the usage lines */
+    const char *help;
+    size_t helplen;
+#endif
+};
+
+
+/* Compiled, read-only form of a command tree. nodes[0] is the root. */
+struct earg_plan {
+    /* generated plans live in rodata and are never freed */
+    bool rodata;
+
+    struct plannode *nodes;
+    size_t nodescount;
+    struct optioninfo *infos;
+    size_t infoscount;
+    struct planentry *entries;
+    size_t entriescount;
+
+    /* the cached help is compressed against this, generated plans only,
+     * the texts of the tree use earg->dictionary */
+    const char * const *dictionary;
+
+    /* heap bytes held by the plan, zero for generated plans */
+    size_t size;
+    const struct earg_allocator *allocator;
+};
+
+
+int
+plan_compile(struct earg_plan **out, const struct earg *c);
+
+
+void
+plan_dispose(struct earg_plan *plan);
+
+
+int
+plan_footprint(const struct earg *c, struct earg_footprint *f);
+
+
+const struct plannode *
+plan_findchild(const struct plannode *node, const char *name);
+
+
+int
+plan_prefixsearch(const struct plannode *node, const char *prefix,
+        int *first);
+
+
+const struct plannode *
+plan_findchildbyprefix(const struct plannode *node, const char *prefix,
+        int *count);
+
+
+bool
+plan_prefixlisted(const struct plannode *node, int first, int count, int i);
+
+
+#endif  // PLAN_H_
@@ -0,0 +1,52 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <string.h>
+
+#include "toolbox.h"
+#include "prefix.h"
+
+
+/* Names starting with the prefix are contiguous in a sorted table, from
+ * the first name which is not less than the prefix. Returns the number of
+ * them, the first one is stored in first. */
+int
+prefix_search(const void *table, int count, prefix_nameof_t nameof,
+        const char *prefix, int len, int *first) {
+    int mid;
+    int lo = 0;
+    int hi = count;
+
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (strncmp(nameof(table, mid), prefix, len) < 0) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    *first = lo;
+    hi = lo;
+    while ((hi < count) && STRNEQ(nameof(table, hi), prefix, len)) {
+        hi++;
+    }
+
+    return hi - lo;
+}
@@ -16,15 +16,17 @@
  *
  *  Author: Vahid Mardani <vahid.mardani@gmail.com>
  */
-#ifndef COMMAND_H_
-#define COMMAND_H_
+#ifndef PREFIX_H_
+#define PREFIX_H_
 
 
-#include "earg.h"
+/* Name of the i'th item of a table sorted by strcmp() */
+typedef const char * (*prefix_nameof_t) (const void *table, int i);
 
 
-const struct earg_command *
-command_findbyname(const struct earg_command *cmd, const char *name);
+int
+prefix_search(const void *table, int count, prefix_nameof_t nameof,
+        const char *prefix, int len, int *first);
 
 
-#endif  // COMMAND_H_
+#endif  // PREFIX_H_
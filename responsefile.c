@@ -0,0 +1,163 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "allocator.h"
+#include "responsefile.h"
+
+
+#if defined(_POSIX_MAPPED_FILES) && (_POSIX_MAPPED_FILES > 0)
+#define RESPONSEFILE_MMAP
+#include <sys/mman.h>
+#endif
+
+
+#ifdef RESPONSEFILE_MMAP
+
+/* Private writable mapping, pages are copied only when the splitter
+ * writes to them. The file is mapped over an anonymous region one byte
+ * longer, so the terminator of the last word lands on a zero page even
+ * if the size is a multiple of the page size. */
+static char *
+_map(int fd, size_t len) {
+    char *buff;
+
+    buff = mmap(NULL, len + 1, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buff == MAP_FAILED) {
+        return NULL;
+    }
+
+    if (mmap(buff, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd,
+                0) == MAP_FAILED) {
+        munmap(buff, len + 1);
+        return NULL;
+    }
+
+    return buff;
+}
+
+#else
+
+static int
+_read(int fd, char *buff, size_t len) {
+    ssize_t n;
+
+    while (len) {
+        n = read(fd, buff, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+
+        /* truncated meanwhile */
+        if (n == 0) {
+            errno = EIO;
+            return -1;
+        }
+
+        buff += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+#endif
+
+
+struct responsefile *
+responsefile_open(const char *path, const struct earg_allocator *a) {
+    int fd;
+    int err;
+    struct stat st;
+    struct responsefile *f = NULL;
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    if (fstat(fd, &st)) {
+        goto failed;
+    }
+
+    if (!S_ISREG(st.st_mode)) {
+        errno = EINVAL;
+        goto failed;
+    }
+
+#ifdef RESPONSEFILE_MMAP
+    /* empty files are not mapped, the byte after the struct is used */
+    f = allocator_malloc(a, sizeof(struct responsefile) + 1);
+    if (f == NULL) {
+        errno = ENOMEM;
+        goto failed;
+    }
+
+    f->len = st.st_size;
+    f->mapped = f->len > 0;
+    f->buff = f->mapped? _map(fd, f->len): (char *)(f + 1);
+    if (f->buff == NULL) {
+        goto failed;
+    }
+#else
+    /* the contents follow the struct */
+    f = allocator_malloc(a, sizeof(struct responsefile) + st.st_size + 1);
+    if (f == NULL) {
+        errno = ENOMEM;
+        goto failed;
+    }
+
+    f->len = st.st_size;
+    f->mapped = false;
+    f->buff = (char *)(f + 1);
+    if (_read(fd, f->buff, f->len)) {
+        goto failed;
+    }
+#endif
+
+    close(fd);
+    f->next = NULL;
+    return f;
+
+failed:
+    err = errno;
+    allocator_free(a, f);
+    close(fd);
+    errno = err;
+    return NULL;
+}
+
+
+void
+responsefile_close(struct responsefile *f, const struct earg_allocator *a) {
+#ifdef RESPONSEFILE_MMAP
+    if (f->mapped) {
+        munmap(f->buff, f->len + 1);
+    }
+#endif
+
+    allocator_free(a, f);
+}
@@ -0,0 +1,49 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef RESPONSEFILE_H_
+#define RESPONSEFILE_H_
+
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "earg.h"
+
+
+/* Contents of an @file or a config file, private to the parse, so it's
+ * split in place. There is always a byte after the last one for the
+ * splitter. */
+struct responsefile {
+    struct responsefile *next;
+    char *buff;
+    size_t len;
+    bool mapped;
+};
+
+
+/* Returns NULL with errno set on failure */
+struct responsefile *
+responsefile_open(const char *path, const struct earg_allocator *a);
+
+
+void
+responsefile_close(struct responsefile *f, const struct earg_allocator *a);
+
+
+#endif  // RESPONSEFILE_H_
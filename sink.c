@@ -0,0 +1,149 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "toolbox.h"
+#include "allocator.h"
+#include "sink.h"
+
+
+void
+sink_init(struct earg_sink *s, earg_write_t write, void *ptr, char *buff,
+        size_t size, const struct earg_allocator *allocator) {
+    s->write = write;
+    s->ptr = ptr;
+    s->buff = buff;
+    s->size = buff? size: 0;
+    s->len = 0;
+    s->allocator = allocator;
+}
+
+
+int
+sink_flush(struct earg_sink *s) {
+    int status = 0;
+
+    if (s->len && (s->write(s->ptr, s->buff, s->len) == -1)) {
+        status = -1;
+    }
+
+    s->len = 0;
+    return status;
+}
+
+
+int
+sink_write(struct earg_sink *s, const char *data, size_t len) {
+    if (len > (s->size - s->len)) {
+        if (sink_flush(s)) {
+            return -1;
+        }
+
+        /* larger than the whole buffer, bypass it */
+        if (len >= s->size) {
+            return s->write(s->ptr, data, len);
+        }
+    }
+
+    memcpy(s->buff + s->len, data, len);
+    s->len += len;
+    return len;
+}
+
+
+int
+sink_printf(struct earg_sink *s, const char *fmt, ...) {
+    va_list args;
+    char *tmp;
+    int n;
+
+    va_start(args, fmt);
+    n = vsnprintf(s->buff + s->len, s->size - s->len, fmt, args);
+    va_end(args);
+    if (n < 0) {
+        return -1;
+    }
+
+    if (n < (s->size - s->len)) {
+        s->len += n;
+        return n;
+    }
+
+    if (sink_flush(s)) {
+        return -1;
+    }
+
+    if (n < s->size) {
+        va_start(args, fmt);
+        vsnprintf(s->buff, s->size, fmt, args);
+        va_end(args);
+        s->len = n;
+        return n;
+    }
+
+    /* rare, the formatted text is larger than the whole buffer */
+    tmp = allocator_malloc(s->allocator, n + 1);
+    if (tmp == NULL) {
+        return -1;
+    }
+
+    va_start(args, fmt);
+    vsnprintf(tmp, n + 1, fmt, args);
+    va_end(args);
+    n = s->write(s->ptr, tmp, n);
+    allocator_free(s->allocator, tmp);
+    return n;
+}
+
+
+int
+sink_collect(void *ptr, const char *data, size_t len) {
+    struct sinkbuffer *b = ptr;
+    char *buff;
+    size_t size;
+
+    if ((b->len + len) > b->size) {
+        size = MAX(b->size * 2, b->len + len);
+        buff = allocator_realloc(b->allocator, b->buff, size);
+        if (buff == NULL) {
+            b->failed = true;
+            return -1;
+        }
+
+        b->buff = buff;
+        b->size = size;
+    }
+
+    memcpy(b->buff + b->len, data, len);
+    b->len += len;
+    return len;
+}
+
+
+int
+earg_sink_file(void *file, const char *data, size_t len) {
+    if (fwrite(data, 1, len, file) != len) {
+        return -1;
+    }
+
+    return len;
+}
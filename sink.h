@@ -0,0 +1,61 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef SINK_H_
+#define SINK_H_
+
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "earg.h"
+
+
+/* Growing memory target of sink_collect() */
+struct sinkbuffer {
+    char *buff;
+    size_t len;
+    size_t size;
+    bool failed;
+    const struct earg_allocator *allocator;
+};
+
+
+void
+sink_init(struct earg_sink *s, earg_write_t write, void *ptr, char *buff,
+        size_t size, const struct earg_allocator *allocator);
+
+
+int
+sink_write(struct earg_sink *s, const char *data, size_t len);
+
+
+int
+sink_printf(struct earg_sink *s, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+
+int
+sink_flush(struct earg_sink *s);
+
+
+int
+sink_collect(void *ptr, const char *data, size_t len);
+
+
+#endif  // SINK_H_
@@ -0,0 +1,147 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <string.h>
+
+#include "toolbox.h"
+#include "splitter.h"
+
+
+void
+splitter_init(struct splitter *s, char *buff, size_t len, size_t size,
+        bool eol) {
+    s->buff = buff;
+    s->size = size;
+    s->len = len;
+    s->r = 0;
+    s->w = 0;
+    s->start = 0;
+    s->quote = 0;
+    s->escape = false;
+    s->inword = false;
+    s->eol = eol;
+}
+
+
+/* Append bytes to the buffer, one byte is always kept for the last
+ * word's terminator. */
+int
+splitter_feed(struct splitter *s, const char *bytes, size_t n) {
+    if ((s->eol) || ((s->len + n) >= s->size)) {
+        return -1;
+    }
+
+    memcpy(s->buff + s->len, bytes, n);
+    s->len += n;
+    return 0;
+}
+
+
+void
+splitter_eol(struct splitter *s) {
+    s->eol = true;
+}
+
+
+/* The write cursor never passes the read cursor, so the unquoted word is
+ * written over the bytes already consumed. */
+enum splitter_status
+splitter_next(struct splitter *s, char **word) {
+    char c;
+
+    while (s->r < s->len) {
+        c = s->buff[s->r++];
+
+        if (s->escape) {
+            s->escape = false;
+
+            /* inside double quotes only the quote and backslash escape */
+            if ((s->quote == '"') && (c != '"') && (c != '\\')) {
+                s->buff[s->w++] = '\\';
+            }
+
+            /* line continuation */
+            if ((c != '\n') || s->quote) {
+                s->buff[s->w++] = c;
+                s->inword = true;
+            }
+            continue;
+        }
+
+        if (s->quote == '\'') {
+            if (c == '\'') {
+                s->quote = 0;
+            }
+            else {
+                s->buff[s->w++] = c;
+            }
+            continue;
+        }
+
+        if (c == '\\') {
+            s->escape = true;
+            continue;
+        }
+
+        if (s->quote == '"') {
+            if (c == '"') {
+                s->quote = 0;
+            }
+            else {
+                s->buff[s->w++] = c;
+            }
+            continue;
+        }
+
+        if ((c == '\'') || (c == '"')) {
+            s->quote = c;
+            s->inword = true;
+            continue;
+        }
+
+        if (ISBLANK(c)) {
+            if (s->inword) {
+                goto word;
+            }
+
+            continue;
+        }
+
+        s->buff[s->w++] = c;
+        s->inword = true;
+    }
+
+    if (!s->eol) {
+        return SPLITTER_MORE;
+    }
+
+    if (s->quote || s->escape) {
+        return SPLITTER_ERROR;
+    }
+
+    if (!s->inword) {
+        return SPLITTER_END;
+    }
+
+word:
+    s->buff[s->w] = 0;
+    *word = s->buff + s->start;
+    s->inword = false;
+    s->start = ++s->w;
+    return SPLITTER_WORD;
+}
@@ -0,0 +1,70 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef SPLITTER_H_
+#define SPLITTER_H_
+
+
+#include <stdbool.h>
+#include <stddef.h>
+
+
+enum splitter_status {
+    SPLITTER_ERROR = -1,
+    SPLITTER_END = 0,
+    SPLITTER_WORD = 1,
+    SPLITTER_MORE = 2,
+};
+
+
+/* Shell-like word splitter, words are unquoted in place and terminated
+ * with NUL inside the same buffer. */
+struct splitter {
+    char *buff;
+    size_t size;
+    size_t len;
+    size_t r;
+    size_t w;
+    size_t start;
+    char quote;
+    bool escape;
+    bool inword;
+
+    /* no more bytes will be appended */
+    bool eol;
+};
+
+
+void
+splitter_init(struct splitter *s, char *buff, size_t len, size_t size,
+        bool eol);
+
+
+int
+splitter_feed(struct splitter *s, const char *bytes, size_t n);
+
+
+void
+splitter_eol(struct splitter *s);
+
+
+enum splitter_status
+splitter_next(struct splitter *s, char **word);
+
+
+#endif  // SPLITTER_H_
@@ -22,13 +22,53 @@
 
 #include "earg.h"
 #include "cmdstack.h"
-#include "optiondb.h"
+#include "plan.h"
+#include "tokenizer.h"
+
+
+struct defaults;
 
 
 struct earg_state {
+    struct earg_sink out;
+    struct earg_sink err;
+
+    /* default sink buffers */
+    char outbuff[CONFIG_EARG_SINK_BUFFSIZE];
+    char errbuff[CONFIG_EARG_SINK_BUFFSIZE];
     struct cmdstack cmdstack;
-    struct optiondb optiondb;
+    struct tokenizer tokenizer;
+
+    /* incremental parsing, see earg_feed() */
+    const struct earg *earg;
+    const struct optioninfo *pending;
+    enum earg_status status;
+    bool finished;
+
+    /* compiled on the fly when the earg has no plan */
+    struct earg_plan *plan;
+    const struct plannode *node;
+
     size_t positionals;
+
+    /* the first positional of the current command, for suggestions */
+    const char *stray;
+
+    /* pending elog verbosity, ELOG_UNKNOWN if not changed */
+    int verbosity;
+
+    /* set by earg_parse_batch(), the environment and the config file are
+     * read once for all the lines, and the verbosity is reported per line
+     * instead of being applied */
+    const struct defaults *defaults;
+
+#ifdef CONFIG_EARG_STATS
+    struct earg_stats stats;
+    uint64_t start;
+    struct earg_statsaggregate *aggregate;
+#endif
+
+    unsigned char occurances[CONFIG_EARG_OPTIONS_MAX];
 };
 
 
@@ -0,0 +1,111 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <string.h>
+#include <time.h>
+
+#include "earg.h"
+#include "toolbox.h"
+#include "state.h"
+#include "stats.h"
+
+
+#ifdef CONFIG_EARG_STATS
+
+uint64_t
+stats_now() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+void
+stats_begin(struct earg_state *state) {
+    memset(&state->stats, 0, sizeof(state->stats));
+    state->start = stats_now();
+}
+
+
+static void
+_aggregate(struct earg_statsaggregate *a, const struct earg_stats *s,
+        enum earg_status status) {
+    struct earg_stats *t = &a->total;
+
+    if ((a->calls == 0) || (s->ns > a->slowest.ns)) {
+        a->slowest = *s;
+    }
+
+    a->calls++;
+    if (status < EARG_OK) {
+        a->failures++;
+    }
+
+    t->tokens += s->tokens;
+    t->probes += s->probes;
+    t->lookups += s->lookups;
+    t->eats += s->eats;
+    t->eatns += s->eatns;
+    t->heap += s->heap;
+    t->depth = MAX(t->depth, s->depth);
+    t->ns += s->ns;
+}
+
+
+void
+stats_end(struct earg_state *state, enum earg_status status) {
+    struct earg_stats *s = &state->stats;
+
+    s->ns = stats_now() - state->start;
+    s->probes += state->tokenizer.probes;
+    s->depth = state->cmdstack.len;
+    s->command = cmdstack_last(&state->cmdstack);
+
+    if (state->aggregate) {
+        _aggregate(state->aggregate, s, status);
+    }
+}
+
+#endif
+
+
+const struct earg_stats *
+earg_state_stats(earg_state_t state) {
+#ifdef CONFIG_EARG_STATS
+    return state? &state->stats: NULL;
+#else
+    return NULL;
+#endif
+}
+
+
+int
+earg_state_aggregate(earg_state_t state,
+        struct earg_statsaggregate *aggregate) {
+#ifdef CONFIG_EARG_STATS
+    if (state == NULL) {
+        return -1;
+    }
+
+    state->aggregate = aggregate;
+    return 0;
+#else
+    return -1;
+#endif
+}
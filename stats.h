@@ -0,0 +1,58 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef STATS_H_
+#define STATS_H_
+
+
+#include <stdint.h>
+
+#include "earg.h"
+
+
+/* Counters compile away when CONFIG_EARG_STATS is disabled */
+#ifdef CONFIG_EARG_STATS
+#define STATS_INC(s, f) ((s)->f++)
+#define STATS_ADD(s, f, v) ((s)->f += (v))
+#else
+#define STATS_INC(s, f) ((void)0)
+#define STATS_ADD(s, f, v) ((void)(v))
+#endif
+
+
+#ifdef CONFIG_EARG_STATS
+
+struct earg_state;
+
+
+/* monotonic clock, in nanoseconds */
+uint64_t
+stats_now();
+
+
+void
+stats_begin(struct earg_state *state);
+
+
+void
+stats_end(struct earg_state *state, enum earg_status status);
+
+#endif
+
+
+#endif  // STATS_H_
@@ -0,0 +1,381 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "earg.h"
+
+
+/* Stress test of the reentrant parsers. Threads parse a fixed set of
+ * command lines against the same compiled tree, each one with its own
+ * state, alternating earg_parse_r() and earg_parse_line(). Every result
+ * is compared to the one of a single threaded run. Build with
+ * -DEARG_SANITIZE=thread to catch the races the comparison can't. */
+
+
+#define ARGSMAX 12
+#define TRACEMAX 256
+#define LINEMAX 256
+
+
+struct config {
+    unsigned int threads;
+    unsigned int iterations;
+};
+
+
+static struct config config = {
+    .threads = 8,
+    .iterations = 2000,
+};
+
+
+static struct earg_option _options[] = {
+    {"threads", 't', "N", 0, "Parsing threads, default: 8",
+        EARG_TYPE_UINT, offsetof(struct config, threads)},
+    {"iterations", 'n', "N", 0, "Parses per thread, default: 2000",
+        EARG_TYPE_UINT, offsetof(struct config, iterations)},
+    {NULL}
+};
+
+
+static struct earg _cli = {
+    .options = _options,
+    .userptr = &config,
+    .header = "Parse against a shared compiled tree on many threads and "
+        "compare the results to a single threaded run.",
+    .flags = EARG_NOELOG,
+};
+
+
+/* What a parse did, the eaten arguments and the output included */
+struct result {
+    enum earg_status status;
+    const struct earg_command *command;
+    int verbosity;
+    size_t output;
+    size_t len;
+    char trace[TRACEMAX];
+};
+
+
+/* eaters and sinks write the result of their own thread, the tree is
+ * shared, so the userptrs are read-only names */
+static __thread struct result *_result;
+
+
+static enum earg_eatstatus
+_eat(const struct earg_option *option, const char *value, void *userptr) {
+    struct result *r = _result;
+    int n;
+
+    n = snprintf(r->trace + r->len, sizeof(r->trace) - r->len, "%s:%c=%s;",
+            (const char *)userptr, option? option->key: '@',
+            value? value: "");
+    if (n > 0) {
+        r->len += n;
+    }
+
+    if (r->len >= sizeof(r->trace)) {
+        r->len = sizeof(r->trace) - 1;
+    }
+
+    return EARG_EAT_OK;
+}
+
+
+static int
+_collect(void *ptr, const char *data, size_t len) {
+    _result->output += len;
+    return 0;
+}
+
+
+static struct earg_option _rootoptions[] = {
+    {"level", 'l', "N", 0, "Level"},
+    {"name", 'N', "NAME", 0, "Name"},
+    {"tag", 'T', "TAG", EARG_OPTION_MULTIPLE, "Tag, may be repeated"},
+    {NULL}
+};
+
+
+static struct earg_option _connectoptions[] = {
+    {"port", 'p', "PORT", 0, "Port"},
+    {NULL}
+};
+
+
+static struct earg_option _listenoptions[] = {
+    {"backlog", 'b', "N", 0, "Backlog"},
+    {NULL}
+};
+
+
+static struct earg_command _connect = {
+    .name = "connect",
+    .args = "HOST",
+    .options = _connectoptions,
+    .eat = _eat,
+    .userptr = "connect",
+};
+
+
+static struct earg_command _listen = {
+    .name = "listen",
+    .options = _listenoptions,
+    .eat = _eat,
+    .userptr = "listen",
+};
+
+
+static const struct earg_command *_netcommands[] = {
+    &_connect,
+    &_listen,
+    NULL
+};
+
+
+static struct earg_command _net = {
+    .name = "net",
+    .commands = _netcommands,
+    .eat = _eat,
+    .userptr = "net",
+};
+
+
+static const struct earg_command *_commands[] = {
+    &_net,
+    NULL
+};
+
+
+static struct earg _tree = {
+    .options = _rootoptions,
+    .commands = _commands,
+    .args = "[FILE...]",
+    .eat = _eat,
+    .userptr = "root",
+    .version = "1.0.0",
+};
+
+
+/* successful, failing and exiting parses */
+static const char *_cases[][ARGSMAX] = {
+    {"stress", "-l", "3", "--name=foo", "-T", "a", "-Tb", "x", "y"},
+    {"stress", "net", "connect", "-p", "80", "example.org"},
+    {"stress", "-vvv", "net", "listen", "--backlog=4"},
+    {"stress", "--verbosity=debug", "-N", "bar", "net", "listen"},
+    {"stress", "net", "connect", "--bogus", "host"},
+    {"stress", "net", "listen", "extra"},
+    {"stress", "-l"},
+    {"stress", "-l", "1", "-l", "2"},
+    {"stress", "--help"},
+    {"stress", "net", "connect", "--usage"},
+    {"stress", "--version"},
+};
+
+
+#define CASES (sizeof(_cases) / sizeof(_cases[0]))
+
+
+struct worker {
+    pthread_t thread;
+    unsigned int index;
+    unsigned long parses;
+    unsigned long mismatches;
+};
+
+
+static struct result _expected[CASES];
+
+
+static int
+_argc(const char **argv) {
+    int argc = 0;
+
+    while ((argc < ARGSMAX) && argv[argc]) {
+        argc++;
+    }
+
+    return argc;
+}
+
+
+static void
+_parse(earg_state_t state, unsigned int c, bool line,
+        struct result *r) {
+    const char **argv = _cases[c];
+    int argc = _argc(argv);
+    char buff[LINEMAX];
+    size_t len = 0;
+    int i;
+
+    memset(r, 0, sizeof(struct result));
+    _result = r;
+    if (!line) {
+        r->status = earg_parse_r(&_tree, state, argc, argv, &r->command);
+        r->verbosity = earg_state_verbosity(state);
+        return;
+    }
+
+    for (i = 0; i < argc; i++) {
+        len += snprintf(buff + len, sizeof(buff) - len, "%s%s", i? " ": "",
+                argv[i]);
+    }
+
+    r->status = earg_parse_line(&_tree, state, buff, &r->command);
+    r->verbosity = earg_state_verbosity(state);
+}
+
+
+static bool
+_same(const struct result *a, const struct result *b) {
+    return (a->status == b->status) && (a->command == b->command) &&
+        (a->verbosity == b->verbosity) && (a->output == b->output) &&
+        (a->len == b->len) && (memcmp(a->trace, b->trace, a->len) == 0);
+}
+
+
+static earg_state_t
+_state_new() {
+    struct earg_sink sink = {.write = _collect};
+    earg_state_t state = malloc(earg_state_size());
+
+    if (state == NULL) {
+        return NULL;
+    }
+
+    earg_state_init(state, earg_state_size());
+    earg_state_sinks(state, &sink, &sink);
+    return state;
+}
+
+
+static void *
+_worker(void *arg) {
+    struct worker *w = arg;
+    struct result r;
+    earg_state_t state;
+    unsigned int i;
+    unsigned int c;
+
+    state = _state_new();
+    if (state == NULL) {
+        w->mismatches++;
+        return NULL;
+    }
+
+    for (i = 0; i < config.iterations; i++) {
+        c = (i + w->index) % CASES;
+        _parse(state, c, (i + w->index) & 1, &r);
+        w->parses++;
+        if (!_same(&r, _expected + c)) {
+            fprintf(stderr, "thread %u, case %u: mismatch\n", w->index, c);
+            w->mismatches++;
+        }
+    }
+
+    free(state);
+    return NULL;
+}
+
+
+int
+main(int argc, const char **argv) {
+    int ret = EXIT_FAILURE;
+    unsigned int i;
+    unsigned long parses = 0;
+    unsigned long mismatches = 0;
+    struct worker *workers = NULL;
+    struct result r;
+    earg_state_t state = NULL;
+    enum earg_status status;
+
+    status = earg_parse(&_cli, argc, argv, NULL);
+    earg_dispose(&_cli);
+    if (status == EARG_OK_EXIT) {
+        return EXIT_SUCCESS;
+    }
+
+    if (status != EARG_OK) {
+        return EXIT_FAILURE;
+    }
+
+    if ((config.threads == 0) || (config.iterations == 0)) {
+        fprintf(stderr, "threads and iterations must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    if (earg_compile(&_tree)) {
+        fprintf(stderr, "earg_compile() failed, see above\n");
+        return EXIT_FAILURE;
+    }
+
+    /* the reference results, both parsers must agree */
+    state = _state_new();
+    if (state == NULL) {
+        goto terminate;
+    }
+
+    for (i = 0; i < CASES; i++) {
+        _parse(state, i, false, _expected + i);
+        _parse(state, i, true, &r);
+        if (!_same(&r, _expected + i)) {
+            fprintf(stderr, "case %u: earg_parse_r() and earg_parse_line() "
+                    "disagree\n", i);
+            goto terminate;
+        }
+    }
+
+    workers = calloc(config.threads, sizeof(struct worker));
+    if (workers == NULL) {
+        goto terminate;
+    }
+
+    for (i = 0; i < config.threads; i++) {
+        workers[i].index = i;
+        if (pthread_create(&workers[i].thread, NULL, _worker,
+                    workers + i)) {
+            fprintf(stderr, "cannot create thread %u\n", i);
+            config.threads = i;
+            break;
+        }
+    }
+
+    for (i = 0; i < config.threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        parses += workers[i].parses;
+        mismatches += workers[i].mismatches;
+    }
+
+    printf("%u threads, %lu parses, %lu mismatches\n", config.threads,
+            parses, mismatches);
+    if (mismatches == 0) {
+        ret = EXIT_SUCCESS;
+    }
+
+terminate:
+    free(workers);
+    free(state);
+    earg_plan_dispose(&_tree);
+    return ret;
+}
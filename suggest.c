@@ -0,0 +1,114 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <string.h>
+
+#include "suggest.h"
+
+
+/* Returns -1 if the pattern is empty or too long to be matched */
+int
+suggest_init(struct suggest *s, const char *pattern, int len) {
+    int i;
+    unsigned char c;
+
+    if ((len <= 0) || (len > SUGGEST_MAXLEN)) {
+        return -1;
+    }
+
+    memset(s->peq, 0, sizeof(s->peq));
+    for (i = 0; i < len; i++) {
+        c = pattern[i];
+        if (c < 128) {
+            s->peq[c] |= 1u << i;
+        }
+    }
+
+    /* about a third of the typed characters may be wrong, nothing is
+     * suggested for a single character */
+    s->len = len;
+    s->bound = (len + 1) / 3;
+    s->best = NULL;
+    s->distance = s->bound + 1;
+    return 0;
+}
+
+
+/* Levenshtein distance between the pattern and the text, one column of
+ * the DP matrix per character of the text, as bit vectors of vertical
+ * deltas. Gives up once the distance can't get under the limit. */
+static int
+_distance(const struct suggest *s, const char *text, int n, int limit) {
+    int j;
+    int score = s->len;
+    unsigned char c;
+    uint32_t last = 1u << (s->len - 1);
+    uint32_t pv = ~0u;
+    uint32_t mv = 0;
+    uint32_t eq;
+    uint32_t xv;
+    uint32_t xh;
+    uint32_t ph;
+    uint32_t mh;
+
+    for (j = 0; j < n; j++) {
+        c = text[j];
+        eq = (c < 128)? s->peq[c]: 0;
+        xv = eq | mv;
+        xh = (((eq & pv) + pv) ^ pv) | eq;
+        ph = mv | ~(xh | pv);
+        mh = pv & xh;
+
+        if (ph & last) {
+            score++;
+        }
+        else if (mh & last) {
+            score--;
+        }
+
+        /* the first row is 0, 1, 2, ... */
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+
+        /* each remaining character lowers the score by one at most */
+        if ((score - (n - j - 1)) >= limit) {
+            return limit;
+        }
+    }
+
+    return score;
+}
+
+
+void
+suggest_try(struct suggest *s, const char *name) {
+    int n = strlen(name);
+    int distance;
+
+    if (((n - s->len) >= s->distance) || ((s->len - n) >= s->distance)) {
+        return;
+    }
+
+    distance = _distance(s, name, n, s->distance);
+    if (distance < s->distance) {
+        s->distance = distance;
+        s->best = name;
+    }
+}
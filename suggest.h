@@ -0,0 +1,53 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef SUGGEST_H_
+#define SUGGEST_H_
+
+
+#include <stdint.h>
+
+
+/* Longest name suggestions are made for, one bit per character */
+#define SUGGEST_MAXLEN 32
+
+
+/* Closest name to a mistyped one, using Myers' bit-parallel edit
+ * distance. Everything lives in the struct, nothing is allocated. */
+struct suggest {
+    /* bitmask of the pattern positions of each ascii character */
+    uint32_t peq[128];
+    int len;
+
+    /* names farther than this are ignored */
+    int bound;
+
+    const char *best;
+    int distance;
+};
+
+
+int
+suggest_init(struct suggest *s, const char *pattern, int len);
+
+
+void
+suggest_try(struct suggest *s, const char *name);
+
+
+#endif  // SUGGEST_H_
@@ -0,0 +1,109 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include "test.h"
+
+
+/* Everything of a tree is allocated through its allocator, the global one
+ * is left alone. */
+
+
+static enum earg_eatstatus
+_eat(const struct earg_option *option, const char *value, void *userptr) {
+    return option? EARG_EAT_OK: EARG_EAT_UNRECOGNIZED;
+}
+
+
+static struct earg_option _options[] = {
+    {"name", 'n', "NAME", 0, "Name"},
+    {"all", 'a', NULL, 0, "All"},
+    {NULL}
+};
+
+
+static struct earg_command _sub = {
+    .name = "sub",
+    .options = _options,
+    .eat = _eat,
+};
+
+
+static const struct earg_command *_commands[] = {
+    &_sub,
+    NULL
+};
+
+
+static struct earg _tree = {
+    .options = _options,
+    .commands = _commands,
+    .eat = _eat,
+    .flags = EARG_NOELOG,
+};
+
+
+int
+main() {
+    struct capture out;
+    struct capture err;
+    struct earg_countingallocator counter;
+    struct earg_countingallocator global;
+    struct earg_candidate candidates[4];
+    earg_state_t state = test_state(&out, &err);
+    char line[1024];
+    size_t start;
+    size_t allocs;
+
+    earg_allocator_set(earg_countingallocator_init(&global, NULL));
+    _tree.allocator = earg_countingallocator_init(&counter, NULL);
+
+    CHECK(earg_compile(&_tree) == 0);
+    CHECK(counter.allocs > 0);
+    CHECK(counter.current > 0);
+    allocs = counter.allocs;
+
+    CHECK_STATUS(test_parse(&_tree, state, &out, &err, "p sub -an x",
+                NULL), EARG_OK);
+    CHECK(counter.allocs == allocs);
+
+    /* a diagnostic larger than the sink buffer */
+    memset(line, 'x', sizeof(line));
+    memcpy(line, "p --", 4);
+    line[CONFIG_EARG_SINK_BUFFSIZE * 2] = 0;
+    CHECK_STATUS(test_parse(&_tree, state, &out, &err, line, NULL),
+            EARG_USERERROR);
+    CHECK(err.len > CONFIG_EARG_SINK_BUFFSIZE);
+    CHECK(counter.allocs > allocs);
+    allocs = counter.allocs;
+
+    /* a line too long for the completion stack buffer */
+    memset(line, ' ', sizeof(line));
+    memcpy(line, "p", 1);
+    strcpy(line + CONFIG_EARG_COMPLETE_BUFFSIZE, "--na");
+    CHECK(earg_complete(&_tree, line, strlen(line), &start, candidates,
+                4) == 1);
+    CHECK(counter.allocs > allocs);
+
+    free(state);
+    earg_plan_dispose(&_tree);
+    CHECK(counter.current == 0);
+    CHECK(counter.peak >= counter.current);
+    CHECK(global.allocs == 0);
+    earg_allocator_set(NULL);
+    return TEST_EXIT();
+}
@@ -0,0 +1,114 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include "test.h"
+
+
+/* The positionals count against the argument hints, a multi-line hint
+ * accepts the counts of any of its lines. */
+
+
+static enum earg_eatstatus
+_eat(const struct earg_option *option, const char *value, void *userptr) {
+    return EARG_EAT_OK;
+}
+
+
+static struct earg_command _single = {
+    .name = "single",
+    .args = "NAME [VALUE]",
+    .eat = _eat,
+};
+
+
+static struct earg_command _multi = {
+    .name = "multi",
+    .args = "[NAME]\nA B C",
+    .eat = _eat,
+};
+
+
+static struct earg_command _variadic = {
+    .name = "variadic",
+    .args = "NAME\nA B FILE...",
+    .eat = _eat,
+};
+
+
+static const struct earg_command *_commands[] = {
+    &_single,
+    &_multi,
+    &_variadic,
+    NULL
+};
+
+
+static struct earg _tree = {
+    .commands = _commands,
+    .eat = _eat,
+    .flags = EARG_NOELOG,
+};
+
+
+struct testcase {
+    const char *line;
+    enum earg_status status;
+};
+
+
+static const struct testcase _cases[] = {
+    {"p single", EARG_USERERROR},
+    {"p single a", EARG_OK},
+    {"p single a b", EARG_OK},
+    {"p single a b c", EARG_USERERROR},
+    {"p multi", EARG_OK},
+    {"p multi a", EARG_OK},
+    {"p multi a b", EARG_USERERROR},
+    {"p multi a b c", EARG_OK},
+    {"p multi a b c d", EARG_USERERROR},
+    {"p variadic", EARG_USERERROR},
+    {"p variadic a", EARG_OK},
+    {"p variadic a b", EARG_USERERROR},
+    {"p variadic a b c", EARG_OK},
+    {"p variadic a b c d e", EARG_OK},
+};
+
+
+#define CASES (sizeof(_cases) / sizeof(_cases[0]))
+
+
+int
+main() {
+    int i;
+    struct capture out;
+    struct capture err;
+    earg_state_t state = test_state(&out, &err);
+
+    CHECK(earg_compile(&_tree) == 0);
+    for (i = 0; i < CASES; i++) {
+        CHECK_STATUS(test_parse(&_tree, state, &out, &err, _cases[i].line,
+                    NULL), _cases[i].status);
+        if (_cases[i].status == EARG_USERERROR) {
+            CHECK_OUTPUT(&err, "invalid positional arguments count");
+        }
+    }
+
+    free(state);
+    earg_plan_dispose(&_tree);
+    return TEST_EXIT();
+}
@@ -0,0 +1,148 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <elog.h>
+
+#include "test.h"
+
+
+/* earg_parse_batch() reads the environment and the config file once for
+ * all the lines and reports the verbosity of each line. */
+
+
+#define LINES 6
+
+
+static int _names;
+static int _alls;
+
+
+/* called by the workers */
+static enum earg_eatstatus
+_eat(const struct earg_option *option, const char *value, void *userptr) {
+    if (option == NULL) {
+        return EARG_EAT_OK;
+    }
+
+    if (option->key == 'a') {
+        __atomic_add_fetch(&_alls, 1, __ATOMIC_RELAXED);
+    }
+    else if (strcmp(value, "fromconfig") == 0) {
+        __atomic_add_fetch(&_names, 1, __ATOMIC_RELAXED);
+    }
+
+    return EARG_EAT_OK;
+}
+
+
+static struct earg_option _options[] = {
+    {"name", 'n', "NAME", 0, "Name"},
+    {"all", 'a', NULL, 0, "All"},
+    {NULL}
+};
+
+
+static struct earg _tree = {
+    .options = _options,
+    .eat = _eat,
+    .envprefix = "BATCHTEST_",
+    .configfile = "batch.conf",
+};
+
+
+static const char *_lines =
+    "p\n"
+    "p -v\n"
+    "p --verbosity=debug\n"
+    "p -q\n"
+    "p --name=x\n"
+    "p --bogus";
+
+
+static const struct earg_batchresult _expected[LINES] = {
+    {1, EARG_OK, (struct earg_command *)&_tree, -1},
+    {2, EARG_OK, (struct earg_command *)&_tree, ELOG_DEBUG},
+    {3, EARG_OK, (struct earg_command *)&_tree, ELOG_DEBUG},
+    {4, EARG_OK, (struct earg_command *)&_tree, ELOG_WARNING},
+    {5, EARG_OK, (struct earg_command *)&_tree, -1},
+    {6, EARG_USERERROR, NULL, -1},
+};
+
+
+static void
+_check(const struct earg_batchresult *results, ssize_t lines) {
+    int i;
+
+    CHECK(lines == LINES);
+    for (i = 0; i < LINES; i++) {
+        CHECK(results[i].line == _expected[i].line);
+        CHECK_STATUS(results[i].status, _expected[i].status);
+        CHECK(results[i].command == _expected[i].command);
+        CHECK(results[i].verbosity == _expected[i].verbosity);
+    }
+}
+
+
+int
+main() {
+    int workers;
+    char buff[256];
+    struct earg_batchresult results[LINES];
+    ssize_t lines;
+
+    test_write("batch.conf", "name = fromconfig\n");
+    test_write("batch.lines", _lines);
+    setenv("BATCHTEST_ALL", "yes", 1);
+    elog_verbosity = ELOG_INFO;
+
+    CHECK(earg_compile(&_tree) == 0);
+    for (workers = 1; workers <= 4; workers++) {
+        _names = 0;
+        _alls = 0;
+        strcpy(buff, _lines);
+        lines = earg_parse_batch(&_tree, buff, results, LINES, workers);
+        _check(results, lines);
+        CHECK(_names == 4);
+        CHECK(_alls == 5);
+
+        /* nothing is applied */
+        CHECK(elog_verbosity == ELOG_INFO);
+    }
+
+    _names = 0;
+    lines = earg_parse_batchfile(&_tree, "batch.lines", results, LINES, 3);
+    _check(results, lines);
+    CHECK(_names == 4);
+    CHECK(earg_parse_batchfile(&_tree, "batch.missing", results, LINES,
+                3) == -1);
+
+    /* too many lines for the results */
+    strcpy(buff, _lines);
+    CHECK(earg_parse_batch(&_tree, buff, NULL, 0, 1) == LINES);
+    CHECK(earg_parse_batch(&_tree, buff, results, LINES - 1, 1) == -1);
+
+    /* a config file which can't be read fails each line */
+    _tree.configfile = ".";
+    strcpy(buff, "p\np -a");
+    CHECK(earg_parse_batch(&_tree, buff, results, LINES, 2) == 2);
+    CHECK_STATUS(results[0].status, EARG_USERERROR);
+    CHECK_STATUS(results[1].status, EARG_USERERROR);
+
+    earg_plan_dispose(&_tree);
+    return TEST_EXIT();
+}
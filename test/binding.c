@@ -0,0 +1,187 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stddef.h>
+
+#include "earg.h"
+
+
+/* Conversions of the typed options, the limits of each type and one
+ * past them. */
+
+
+struct config {
+    int i;
+    unsigned int u;
+    size_t s;
+    float f;
+};
+
+
+static struct earg_option _options[] = {
+    {"int", 'i', "N", 0, "int", EARG_TYPE_INT, offsetof(struct config, i)},
+    {"uint", 'u', "N", 0, "uint", EARG_TYPE_UINT,
+        offsetof(struct config, u)},
+    {"size", 's', "N", 0, "size", EARG_TYPE_SIZE,
+        offsetof(struct config, s)},
+    {"float", 'f', "N", 0, "float", EARG_TYPE_FLOAT,
+        offsetof(struct config, f)},
+    {NULL}
+};
+
+
+static struct config _config;
+
+
+static struct earg _tree = {
+    .options = _options,
+    .userptr = &_config,
+    .flags = EARG_NOELOG,
+};
+
+
+struct testcase {
+    const char *option;
+    const char *value;
+    enum earg_status status;
+
+    /* the stored value, when it's accepted */
+    unsigned long long expected;
+};
+
+
+static const struct testcase _cases[] = {
+    {"--int", "2147483647", EARG_OK, INT_MAX},
+    {"--int", "-2147483648", EARG_OK, (unsigned long long)INT_MIN},
+    {"--int", "2147483648", EARG_USERERROR},
+    {"--int", "-2147483649", EARG_USERERROR},
+    {"--int", "0x7fffffff", EARG_OK, INT_MAX},
+    {"--uint", "4294967295", EARG_OK, UINT_MAX},
+    {"--uint", "4294967296", EARG_USERERROR},
+    {"--uint", "-1", EARG_USERERROR},
+    {"--uint", "18446744073709551615", EARG_USERERROR},
+    {"--uint", "18446744073709551616", EARG_USERERROR},
+    {"--int", "18446744073709551616", EARG_USERERROR},
+    {"--int", "-18446744073709551616", EARG_USERERROR},
+#if SIZE_MAX == ULLONG_MAX
+    {"--size", "18446744073709551615", EARG_OK, ULLONG_MAX},
+    {"--size", "0xffffffffffffffff", EARG_OK, ULLONG_MAX},
+#endif
+    {"--size", "18446744073709551616", EARG_USERERROR},
+    {"--size", "18446744073709551620", EARG_USERERROR},
+    {"--size", "0x10000000000000000", EARG_USERERROR},
+    {"--size", "184467440737095516150", EARG_USERERROR},
+    {"--size", "4k", EARG_OK, 4096},
+    {"--size", "18446744073709551615k", EARG_USERERROR},
+    {"--size", "", EARG_USERERROR},
+    {"--size", "0x", EARG_USERERROR},
+};
+
+
+#define CASES (sizeof(_cases) / sizeof(_cases[0]))
+
+
+/* floats must be stored as strtof() gives them, bit by bit, the first
+ * ones are a rounding of a halfway case off by one ulp through double */
+static const char *_floats[] = {
+    "6.23338770866394",
+    "5.89923357963562",
+    "1.45718652009964",
+    "0", "-0", "1", "-1", "0.1", "-0.1", "3.14159", "16777215",
+    "16777216", "16777217", "0.0000000001", "0.00000000001",
+    "123456.789", "1e10", "1.5e-3", "340282346638528859811704183484516925440",
+    "1e39", "0x1p-3", "inf", "nan",
+};
+
+
+#define FLOATS (sizeof(_floats) / sizeof(_floats[0]))
+
+
+/* the rejections are expected */
+static int
+_discard(void *ptr, const char *data, size_t len) {
+    return 0;
+}
+
+
+static unsigned long long
+_stored(const char *option) {
+    switch (option[2]) {
+        case 'i':
+            return (unsigned long long)_config.i;
+        case 'u':
+            return _config.u;
+        default:
+            return _config.s;
+    }
+}
+
+
+int
+main() {
+    int i;
+    int failures = 0;
+    char arg[64];
+    const char *argv[2] = {"binding", arg};
+    enum earg_status status;
+    float expected;
+    earg_state_t state;
+    struct earg_sink discard = {.write = _discard};
+
+    state = malloc(earg_state_size());
+    if ((state == NULL) || earg_compile(&_tree)) {
+        return EXIT_FAILURE;
+    }
+    earg_state_init(state, earg_state_size());
+    earg_state_sinks(state, NULL, &discard);
+
+    for (i = 0; i < CASES; i++) {
+        /* negative values would be taken for short options otherwise */
+        snprintf(arg, sizeof(arg), "%s=%s", _cases[i].option,
+                _cases[i].value);
+        status = earg_parse_r(&_tree, state, 2, argv, NULL);
+        if ((status != _cases[i].status) || ((status == EARG_OK) &&
+                    (_stored(arg) != _cases[i].expected))) {
+            fprintf(stderr, "%s: status %d, stored %llu\n", arg, status,
+                    _stored(arg));
+            failures++;
+        }
+    }
+
+    for (i = 0; i < FLOATS; i++) {
+        snprintf(arg, sizeof(arg), "--float=%s", _floats[i]);
+        expected = strtof(_floats[i], NULL);
+        status = earg_parse_r(&_tree, state, 2, argv, NULL);
+        if ((status != EARG_OK) ||
+                memcmp(&_config.f, &expected, sizeof(float))) {
+            fprintf(stderr, "%s: status %d, stored %a, expected %a\n", arg,
+                    status, _config.f, expected);
+            failures++;
+        }
+    }
+
+    printf("%zu cases, %d failures\n", CASES + FLOATS, failures);
+    free(state);
+    earg_plan_dispose(&_tree);
+    return failures? EXIT_FAILURE: EXIT_SUCCESS;
+}
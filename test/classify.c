@@ -0,0 +1,117 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include "test.h"
+
+
+/* Options of all the name lengths around a few machine words, given at
+ * every alignment in buffers which end at their terminator, so a sanitized
+ * build catches a read past it. */
+
+
+#define NAMEMAX 24
+#define VALUEMAX 24
+
+
+static char _names[NAMEMAX + 1][NAMEMAX + 1];
+static struct earg_option _options[NAMEMAX + 1];
+static const struct earg_option *_option;
+static const char *_value;
+
+
+static enum earg_eatstatus
+_eat(const struct earg_option *option, const char *value, void *userptr) {
+    _option = option;
+    _value = value;
+    return EARG_EAT_OK;
+}
+
+
+static struct earg _tree = {
+    .options = _options,
+    .args = "[WORD]",
+    .eat = _eat,
+    .flags = EARG_NOELOG,
+};
+
+
+/* --name=value, or the positional name=value if dashes is zero */
+static void
+_check(earg_state_t state, int namelen, int valuelen, int offset,
+        int dashes) {
+    int len = dashes + namelen + valuelen + 1;
+    char *buff = malloc(offset + len + 1);
+    char *arg = buff + offset;
+    const char *argv[] = {"p", arg};
+
+    memset(arg, '-', dashes);
+    memcpy(arg + dashes, _names[namelen], namelen);
+    arg[dashes + namelen] = '=';
+
+    /* a second '=' inside the value */
+    memset(arg + dashes + namelen + 1, 'v', valuelen);
+    if (valuelen > 1) {
+        arg[len - 2] = '=';
+    }
+    arg[len] = 0;
+
+    _option = NULL;
+    _value = NULL;
+    CHECK_STATUS(earg_parse_r(&_tree, state, 2, argv, NULL), EARG_OK);
+    if (dashes) {
+        CHECK(_option == _options + namelen - 1);
+        CHECK(_value == (arg + dashes + namelen + 1));
+    }
+    else {
+        CHECK(_option == NULL);
+        CHECK(_value == arg);
+    }
+    free(buff);
+}
+
+
+int
+main() {
+    int i;
+    int valuelen;
+    int offset;
+    struct capture out;
+    struct capture err;
+    earg_state_t state = test_state(&out, &err);
+
+    for (i = 0; i < NAMEMAX; i++) {
+        memset(_names[i + 1], 'a' + (i % 2), i + 1);
+        _names[i + 1][0] = 'n';
+        memcpy(_options + i, &(struct earg_option) {_names[i + 1], 'A' + i,
+                "V", 0, ""}, sizeof(struct earg_option));
+    }
+
+    CHECK(earg_compile(&_tree) == 0);
+    for (i = 2; i <= NAMEMAX; i++) {
+        for (valuelen = 0; valuelen <= VALUEMAX; valuelen++) {
+            for (offset = 0; offset < sizeof(size_t); offset++) {
+                _check(state, i, valuelen, offset, 2);
+                _check(state, i, valuelen, offset, 0);
+            }
+        }
+    }
+
+    free(state);
+    earg_plan_dispose(&_tree);
+    return TEST_EXIT();
+}
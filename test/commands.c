@@ -0,0 +1,178 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include "test.h"
+
+
+/* Sub-commands are dispatched through the sorted table of each node, by
+ * name or alias. */
+
+
+static enum earg_eatstatus
+_eat(const struct earg_option *option, const char *value, void *userptr) {
+    return EARG_EAT_OK;
+}
+
+
+/* the root takes no positionals */
+static enum earg_eatstatus
+_rooteat(const struct earg_option *option, const char *value,
+        void *userptr) {
+    return option? EARG_EAT_OK: EARG_EAT_UNRECOGNIZED;
+}
+
+
+static struct earg_command _show = {
+    .name = "show",
+    .aliases = (const char *[]) {"sh", NULL},
+    .eat = _eat,
+};
+
+
+static const struct earg_command *_netcommands[] = {
+    &_show,
+    NULL
+};
+
+
+static struct earg_command _net = {
+    .name = "network",
+    .aliases = (const char *[]) {"net", "n", NULL},
+    .commands = _netcommands,
+    .eat = _eat,
+};
+
+
+static struct earg_command _zeta = {
+    .name = "zeta",
+    .eat = _eat,
+};
+
+
+static struct earg_command _alpha = {
+    .name = "alpha",
+    .aliases = (const char *[]) {"zz", NULL},
+    .eat = _eat,
+};
+
+
+static struct earg_command _show2 = {
+    .name = "show",
+    .eat = _eat,
+};
+
+
+/* declared out of order, the table is sorted at compile time */
+static const struct earg_command *_commands[] = {
+    &_zeta,
+    &_net,
+    &_alpha,
+    &_show2,
+    NULL
+};
+
+
+static struct earg _tree = {
+    .commands = _commands,
+    .eat = _rooteat,
+    .flags = EARG_NOELOG,
+};
+
+
+/* an alias clashes with the name of a sibling */
+static struct earg_command _clash = {
+    .name = "clash",
+    .aliases = (const char *[]) {"zeta", NULL},
+};
+
+
+static const struct earg_command *_clashcommands[] = {
+    &_zeta,
+    &_clash,
+    NULL
+};
+
+
+static struct earg _clashtree = {
+    .commands = _clashcommands,
+    .flags = EARG_NOELOG,
+};
+
+
+struct testcase {
+    const char *line;
+    enum earg_status status;
+    const struct earg_command *command;
+};
+
+
+static const struct testcase _cases[] = {
+    {"p", EARG_OK, (struct earg_command *)&_tree},
+    {"p zeta", EARG_OK, &_zeta},
+    {"p alpha", EARG_OK, &_alpha},
+    {"p zz", EARG_OK, &_alpha},
+    {"p network", EARG_OK, &_net},
+    {"p net", EARG_OK, &_net},
+    {"p n", EARG_OK, &_net},
+    {"p n show", EARG_OK, &_show},
+    {"p net sh", EARG_OK, &_show},
+    {"p show", EARG_OK, &_show2},
+    {"p sh", EARG_USERERROR},
+    {"p netw", EARG_USERERROR},
+    {"p bogus", EARG_USERERROR},
+};
+
+
+#define CASES (sizeof(_cases) / sizeof(_cases[0]))
+
+
+int
+main() {
+    int i;
+    struct capture out;
+    struct capture err;
+    const struct earg_command *command;
+    earg_state_t state = test_state(&out, &err);
+
+    CHECK(earg_compile(&_tree) == 0);
+    for (i = 0; i < CASES; i++) {
+        command = NULL;
+        CHECK_STATUS(test_parse(&_tree, state, &out, &err, _cases[i].line,
+                    &command), _cases[i].status);
+        if (_cases[i].status == EARG_OK) {
+            CHECK(command == _cases[i].command);
+        }
+    }
+
+    /* the chain is printed with the name given */
+    test_parse(&_tree, state, &out, &err, "p n bogus", NULL);
+    CHECK_OUTPUT(&err, "p n: invalid positional arguments count");
+
+    /* aliases follow the name in the help */
+    CHECK_STATUS(test_parse(&_tree, state, &out, &err, "p --help", NULL),
+            EARG_OK_EXIT);
+    CHECK_OUTPUT(&out, "  network, net, n\n");
+    CHECK_OUTPUT(&out, "  alpha, zz\n");
+
+    CHECK(earg_compile(&_clashtree) == -1);
+    CHECK(_clashtree.plan == NULL);
+
+    free(state);
+    earg_plan_dispose(&_tree);
+    return TEST_EXIT();
+}
@@ -0,0 +1,134 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include "test.h"
+
+
+/* earg_complete(), the candidates are checked ',' joined along with the
+ * start of the replaced bytes. */
+
+
+static const char *_modes[] = {"auto", "fast", "slow", NULL};
+
+
+static struct earg_option _options[] = {
+    {"mode", 'm', "MODE", 0, "Mode", EARG_TYPE_ENUM, 0, _modes},
+    {"all", 'a', NULL, 0, "All"},
+    {"max", 'x', "MAX", 0, "Max"},
+    {NULL}
+};
+
+
+static int _mode;
+
+
+static const char *_netaliases[] = {"n", NULL};
+
+
+static struct earg_command _net = {
+    .name = "net",
+    .aliases = _netaliases,
+    .options = _options,
+    .userptr = &_mode,
+};
+
+
+static struct earg_command _new = {
+    .name = "new",
+};
+
+
+static const struct earg_command *_commands[] = {
+    &_net,
+    &_new,
+    NULL
+};
+
+
+static struct earg _tree = {
+    .options = _options,
+    .commands = _commands,
+    .userptr = &_mode,
+    .flags = EARG_NOELOG,
+};
+
+
+static void
+_check(const char *line, size_t start, const char *expected) {
+    struct earg_candidate candidates[8];
+    char joined[256] = "";
+    size_t s = -1;
+    ssize_t count;
+    ssize_t i;
+
+    count = earg_complete(&_tree, line, strlen(line), &s, candidates, 8);
+    for (i = 0; (i < count) && (i < 8); i++) {
+        if (i) {
+            strcat(joined, ",");
+        }
+        strcat(joined, candidates[i].name);
+    }
+
+    if ((s != start) || strcmp(joined, expected)) {
+        fprintf(stderr, "'%s': %zu '%s', expected %zu '%s'\n", line, s,
+                joined, start, expected);
+        _failures++;
+    }
+}
+
+
+int
+main() {
+    char line[300];
+
+    CHECK(earg_compile(&_tree) == 0);
+
+    _check("p ", 2, "net,new");
+    _check("p n", 2, "net,new");
+    _check("p ne", 2, "net,new");
+    _check("p --m", 2, "max,mode");
+    _check("p -", 2, "all,help,max,mode,usage");
+    _check("p --mode ", 9, "auto,fast,slow");
+    _check("p --mode f", 9, "fast");
+    _check("p --mode=", 9, "auto,fast,slow");
+    _check("p --mode=s", 9, "slow");
+    _check("p -am", 2, "");
+    _check("p -ams", 5, "slow");
+    _check("p net --mode=a", 13, "auto");
+
+    /* the start is where the value is read from in the line, the quotes
+     * and escapes before it are kept */
+    _check("p --mode='a", 10, "auto");
+    _check("p --mode='", 10, "auto,fast,slow");
+    _check("p '--mode='a", 11, "auto");
+    _check("p \"--mo\"de=a", 11, "auto");
+    _check("p --mo\\de=a", 10, "auto");
+    _check("p --mode=\\s", 10, "slow");
+    _check("p '--mode=", 10, "auto,fast,slow");
+    _check("p -a'm'f", 7, "fast");
+    _check("p 'ne", 2, "net,new");
+
+    /* too long for the stack */
+    memset(line, ' ', sizeof(line));
+    memcpy(line, "p", 1);
+    strcpy(line + 280, "--mode='f");
+    _check(line, 288, "fast");
+
+    earg_plan_dispose(&_tree);
+    return TEST_EXIT();
+}
@@ -0,0 +1,219 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stddef.h>
+
+#include "test.h"
+
+
+/* The config file, below the command line in precedence, its sections
+ * and its diagnostics. */
+
+
+static char _eaten[256];
+
+
+static enum earg_eatstatus
+_eat(const struct earg_option *option, const char *value, void *userptr) {
+    size_t len = strlen(_eaten);
+
+    if (option == NULL) {
+        return EARG_EAT_UNRECOGNIZED;
+    }
+
+    snprintf(_eaten + len, sizeof(_eaten) - len, "%c=%s|", option->key,
+            value? value: "");
+    return EARG_EAT_OK;
+}
+
+
+struct settings {
+    int count;
+};
+
+
+static struct settings _settings;
+
+
+static struct earg_option _options[] = {
+    {"name", 'n', "NAME", 0, "Name"},
+    {"all", 'a', NULL, 0, "All"},
+    {"tag", 't', "TAG", EARG_OPTION_MULTIPLE, "Tags"},
+    {"count", 'c', "N", 0, "Count", EARG_TYPE_INT,
+        offsetof(struct settings, count)},
+    {NULL}
+};
+
+
+static struct earg_option _showoptions[] = {
+    {"long", 'l', NULL, 0, "Long"},
+    {NULL}
+};
+
+
+static struct earg_command _show = {
+    .name = "show",
+    .options = _showoptions,
+    .eat = _eat,
+};
+
+
+static const struct earg_command *_netcommands[] = {
+    &_show,
+    NULL
+};
+
+
+static struct earg_option _netoptions[] = {
+    {"iface", 'i', "IFACE", 0, "Interface"},
+    {NULL}
+};
+
+
+static struct earg_command _net = {
+    .name = "net",
+    .options = _netoptions,
+    .commands = _netcommands,
+    .eat = _eat,
+};
+
+
+static const struct earg_command *_commands[] = {
+    &_net,
+    NULL
+};
+
+
+static struct earg _tree = {
+    .options = _options,
+    .commands = _commands,
+    .eat = _eat,
+    .userptr = &_settings,
+    .flags = EARG_NOELOG,
+    .configfile = "config.conf",
+};
+
+
+struct testcase {
+    const char *config;
+    const char *line;
+    enum earg_status status;
+    const char *expected;
+};
+
+
+static const struct testcase _cases[] = {
+    {"", "p", EARG_OK, ""},
+    {"# comment\n; comment\n\nname = x\n", "p", EARG_OK, "n=x|"},
+    {"name = \"x y\"\nall\n", "p", EARG_OK, "n=x y|a=|"},
+    {"all = yes\n", "p", EARG_OK, "a=|"},
+    {"all = no\n", "p", EARG_OK, ""},
+    {"tag = x\ntag = y\n", "p", EARG_OK, "t=x|t=y|"},
+
+    /* the command line wins */
+    {"name = x\n", "p --name y", EARG_OK, "n=y|"},
+    {"all\n", "p -a", EARG_OK, "a=|"},
+    {"tag = x\n", "p -ty", EARG_OK, "t=y|"},
+
+    /* only the sections on the command chain are read */
+    {"name = x\n[net]\niface = eth0\n[net.show]\nlong\n", "p", EARG_OK,
+        "n=x|"},
+    {"name = x\n[net]\niface = eth0\n[net.show]\nlong\n", "p net",
+        EARG_OK, "n=x|i=eth0|"},
+    {"name = x\n[net]\niface = eth0\n[net.show]\nlong\n", "p net show",
+        EARG_OK, "n=x|i=eth0|l=|"},
+    {"[ net.show ]\nlong\n", "p net show -l", EARG_OK, "l=|"},
+
+    /* errors, whether the section is on the chain or not */
+    {"bogus = x\n", "p", EARG_USERERROR},
+    {"[net]\nlong\n", "p net", EARG_USERERROR},
+    {"name\n", "p", EARG_USERERROR},
+    {"all = maybe\n", "p", EARG_USERERROR},
+    {"count = x\n", "p", EARG_USERERROR},
+    {"name = x\nname = y\n", "p", EARG_USERERROR},
+    {"[net.bogus]\n", "p", EARG_USERERROR},
+    {"[net\n", "p", EARG_USERERROR},
+    {"= x\n", "p", EARG_USERERROR},
+};
+
+
+#define CASES (sizeof(_cases) / sizeof(_cases[0]))
+
+
+static void
+_diagnostic(earg_state_t state, struct capture *out, struct capture *err,
+        const char *config, const char *expected) {
+    test_write("config.conf", config);
+    CHECK_STATUS(test_parse(&_tree, state, out, err, "p", NULL),
+            EARG_USERERROR);
+    CHECK_OUTPUT(err, expected);
+}
+
+
+int
+main() {
+    int i;
+    struct capture out;
+    struct capture err;
+    earg_state_t state = test_state(&out, &err);
+
+    CHECK(earg_compile(&_tree) == 0);
+    for (i = 0; i < CASES; i++) {
+        _eaten[0] = 0;
+        test_write("config.conf", _cases[i].config);
+        CHECK_STATUS(test_parse(&_tree, state, &out, &err, _cases[i].line,
+                    NULL), _cases[i].status);
+        if (_cases[i].expected) {
+            CHECK_STR(_eaten, _cases[i].expected);
+        }
+    }
+
+    test_write("config.conf", "count = 0x10\n");
+    CHECK_STATUS(test_parse(&_tree, state, &out, &err, "p", NULL), EARG_OK);
+    CHECK(_settings.count == 16);
+
+    /* the file and the line of the error, and the whole section name */
+    _diagnostic(state, &out, &err, "\n[net.bogus]\n",
+            "p: config.conf:2: invalid section -- 'net.bogus'\n");
+    _diagnostic(state, &out, &err, "[bogus.show]\n",
+            "p: config.conf:1: invalid section -- 'bogus.show'\n");
+    _diagnostic(state, &out, &err, "[net.show.bogus]\n",
+            "p: config.conf:1: invalid section -- 'net.show.bogus'\n");
+    _diagnostic(state, &out, &err, "name = x\nbogus\n",
+            "p: config.conf:2: invalid option -- 'bogus'\n");
+    _diagnostic(state, &out, &err, "[net\n",
+            "p: config.conf:1: invalid line\n");
+    _diagnostic(state, &out, &err, "count = x\n",
+            "invalid value 'x' for option -- 'count'\n");
+
+    /* a missing file is ignored, one which can't be read is not */
+    remove("config.conf");
+    _eaten[0] = 0;
+    CHECK_STATUS(test_parse(&_tree, state, &out, &err, "p -a", NULL),
+            EARG_OK);
+    CHECK_STR(_eaten, "a=|");
+
+    _tree.configfile = ".";
+    CHECK_STATUS(test_parse(&_tree, state, &out, &err, "p", NULL),
+            EARG_USERERROR);
+    CHECK_OUTPUT(&err, "p: cannot read config file -- '.': ");
+
+    free(state);
+    earg_plan_dispose(&_tree);
+    return TEST_EXIT();
+}
@@ -0,0 +1,177 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include <stddef.h>
+
+#include "test.h"
+
+
+/* Options of the final command default to ENVTEST_<NAME> variables, the
+ * command line wins over the environment, which wins over the config
+ * file. */
+
+
+/* the last value eaten by the key, and the count of the eat calls */
+static char _values[128][32];
+static int _calls;
+
+
+static enum earg_eatstatus
+_eat(const struct earg_option *option, const char *value, void *userptr) {
+    if (option == NULL) {
+        return EARG_EAT_UNRECOGNIZED;
+    }
+
+    snprintf(_values[option->key], sizeof(_values[0]), "%s",
+            value? value: "-");
+    _calls++;
+    return EARG_EAT_OK;
+}
+
+
+struct settings {
+    int count;
+};
+
+
+static struct settings _settings;
+
+
+static struct earg_option _options[] = {
+    {"name", 'n', "NAME", 0, "Name"},
+    {"dry-run", 'd', NULL, 0, "Dry run"},
+    {"count", 'c', "N", 0, "Count", EARG_TYPE_INT,
+        offsetof(struct settings, count)},
+    {NULL}
+};
+
+
+static struct earg_option _netoptions[] = {
+    {"iface", 'i', "IFACE", 0, "Interface"},
+    {NULL}
+};
+
+
+static struct earg_command _net = {
+    .name = "net",
+    .options = _netoptions,
+    .eat = _eat,
+};
+
+
+static const struct earg_command *_commands[] = {
+    &_net,
+    NULL
+};
+
+
+static struct earg _tree = {
+    .options = _options,
+    .commands = _commands,
+    .eat = _eat,
+    .userptr = &_settings,
+    .flags = EARG_NOELOG,
+    .envprefix = "ENVTEST_",
+    .configfile = "environ.conf",
+};
+
+
+static enum earg_status
+_parse(earg_state_t state, struct capture *out, struct capture *err,
+        const char *line) {
+    memset(_values, 0, sizeof(_values));
+    _calls = 0;
+    _settings.count = 0;
+    return test_parse(&_tree, state, out, err, line, NULL);
+}
+
+
+int
+main() {
+    struct capture out;
+    struct capture err;
+    earg_state_t state = test_state(&out, &err);
+
+    test_write("environ.conf", "");
+    setenv("ENVTEST_BOGUS", "x", 1);
+    setenv("ENVTESTNAME", "x", 1);
+    setenv("ENVTEST_", "x", 1);
+    CHECK(earg_compile(&_tree) == 0);
+
+    CHECK_STATUS(_parse(state, &out, &err, "p"), EARG_OK);
+    CHECK(_calls == 0);
+
+    /* the command line wins, the eater is called once */
+    setenv("ENVTEST_NAME", "env", 1);
+    CHECK_STATUS(_parse(state, &out, &err, "p"), EARG_OK);
+    CHECK_STR(_values['n'], "env");
+    CHECK(_calls == 1);
+    CHECK_STATUS(_parse(state, &out, &err, "p --name cli"), EARG_OK);
+    CHECK_STR(_values['n'], "cli");
+    CHECK(_calls == 1);
+
+    /* and the environment wins over the config file */
+    test_write("environ.conf", "name = file\ndry-run\n");
+    CHECK_STATUS(_parse(state, &out, &err, "p"), EARG_OK);
+    CHECK_STR(_values['n'], "env");
+    CHECK_STR(_values['d'], "-");
+    CHECK(_calls == 2);
+    test_write("environ.conf", "");
+    unsetenv("ENVTEST_NAME");
+
+    /* flags */
+    setenv("ENVTEST_DRY_RUN", "yes", 1);
+    CHECK_STATUS(_parse(state, &out, &err, "p"), EARG_OK);
+    CHECK_STR(_values['d'], "-");
+    setenv("ENVTEST_DRY_RUN", "off", 1);
+    CHECK_STATUS(_parse(state, &out, &err, "p"), EARG_OK);
+    CHECK(_calls == 0);
+    setenv("ENVTEST_DRY_RUN", "maybe", 1);
+    CHECK_STATUS(_parse(state, &out, &err, "p"), EARG_USERERROR);
+    CHECK_OUTPUT(&err, "p: invalid value 'maybe' for environment variable "
+            "-- 'ENVTEST_DRY_RUN'\n");
+    CHECK_STATUS(_parse(state, &out, &err, "p -d"), EARG_OK);
+    unsetenv("ENVTEST_DRY_RUN");
+
+    /* typed options */
+    setenv("ENVTEST_COUNT", "0x10", 1);
+    CHECK_STATUS(_parse(state, &out, &err, "p"), EARG_OK);
+    CHECK(_settings.count == 16);
+    CHECK_STATUS(_parse(state, &out, &err, "p -c 3"), EARG_OK);
+    CHECK(_settings.count == 3);
+    setenv("ENVTEST_COUNT", "x", 1);
+    CHECK_STATUS(_parse(state, &out, &err, "p"), EARG_USERERROR);
+    CHECK_OUTPUT(&err, "p: invalid value 'x' for environment variable "
+            "-- 'ENVTEST_COUNT'\n");
+    unsetenv("ENVTEST_COUNT");
+
+    /* only the options visible to the final command */
+    setenv("ENVTEST_IFACE", "eth0", 1);
+    CHECK_STATUS(_parse(state, &out, &err, "p"), EARG_OK);
+    CHECK(_calls == 0);
+    CHECK_STATUS(_parse(state, &out, &err, "p net"), EARG_OK);
+    CHECK_STR(_values['i'], "eth0");
+    setenv("ENVTEST_NAME", "env", 1);
+    CHECK_STATUS(_parse(state, &out, &err, "p net"), EARG_OK);
+    CHECK_STR(_values['n'], "env");
+    CHECK(_calls == 2);
+
+    free(state);
+    earg_plan_dispose(&_tree);
+    return TEST_EXIT();
+}
@@ -0,0 +1,168 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include "test.h"
+
+
+#define MIN(x, y) ((x) < (y)? (x): (y))
+
+
+/* earg_feed() must give the same results as earg_parse_line() however
+ * the line is chunked. */
+
+
+/* the eaten options and positionals, '|' separated */
+static char _eaten[256];
+
+
+static enum earg_eatstatus
+_eat(const struct earg_option *option, const char *value, void *userptr) {
+    size_t len = strlen(_eaten);
+
+    snprintf(_eaten + len, sizeof(_eaten) - len, "%s%c=%s|",
+            option? "-": "", option? option->key: 'p', value? value: "");
+    return EARG_EAT_OK;
+}
+
+
+static struct earg_option _options[] = {
+    {"name", 'n', "NAME", 0, "Name"},
+    {"all", 'a', NULL, 0, "All"},
+    {NULL}
+};
+
+
+static struct earg_command _sub = {
+    .name = "sub",
+    .options = _options,
+    .args = "[WORD...]",
+    .eat = _eat,
+};
+
+
+static const struct earg_command *_commands[] = {
+    &_sub,
+    NULL
+};
+
+
+static struct earg _tree = {
+    .options = _options,
+    .commands = _commands,
+    .args = "[WORD...]",
+    .eat = _eat,
+    .flags = EARG_NOELOG,
+};
+
+
+static const char *_lines[] = {
+    "p",
+    "p a b c",
+    "p -an 'x y' -- -a",
+    "p --name=\"q \\\" r\" sub  --all  z\\ w ",
+    "p sub -n",
+    "p --bogus a",
+    "p -a -a",
+    "p 'unterminated",
+    NULL
+};
+
+
+int
+main() {
+    int i;
+    size_t chunk;
+    size_t len;
+    size_t fed;
+    char buff[128];
+    char line[128];
+    char expected[256];
+    const struct earg_command *command;
+    const struct earg_command *expectedcommand;
+    struct capture out;
+    struct capture err;
+    enum earg_status status;
+    enum earg_status expectedstatus;
+    earg_state_t state = test_state(&out, &err);
+
+    CHECK(earg_compile(&_tree) == 0);
+    for (i = 0; _lines[i]; i++) {
+        len = strlen(_lines[i]);
+        strcpy(line, _lines[i]);
+        _eaten[0] = 0;
+        expectedcommand = NULL;
+        expectedstatus = earg_parse_line(&_tree, state, line,
+                &expectedcommand);
+        strcpy(expected, _eaten);
+
+        for (chunk = 1; chunk <= len; chunk++) {
+            _eaten[0] = 0;
+            command = NULL;
+            CHECK(earg_feed_begin(&_tree, state, buff, sizeof(buff)) == 0);
+            for (fed = 0; fed < len; fed += chunk) {
+                status = earg_feed(state, _lines[i] + fed,
+                        MIN(chunk, len - fed));
+                if (status != EARG_OK) {
+                    break;
+                }
+            }
+
+            status = earg_feed_end(state, &command);
+            if ((status != expectedstatus) || strcmp(_eaten, expected) ||
+                    (command != expectedcommand)) {
+                fprintf(stderr, "'%s', chunk %zu: status %d, eaten '%s', "
+                        "expected %d, '%s'\n", _lines[i], chunk, status,
+                        _eaten, expectedstatus, expected);
+                _failures++;
+            }
+        }
+    }
+
+    /* a word is eaten once it's complete, before the end of the line */
+    _eaten[0] = 0;
+    earg_feed_begin(&_tree, state, buff, sizeof(buff));
+    CHECK_STATUS(earg_feed(state, "p ab", 4), EARG_OK);
+    CHECK_STR(_eaten, "");
+    CHECK_STATUS(earg_feed(state, "c d", 3), EARG_OK);
+    CHECK_STR(_eaten, "p=abc|");
+    CHECK_STATUS(earg_feed_end(state, NULL), EARG_OK);
+    CHECK_STR(_eaten, "p=abc|p=d|");
+
+    /* errors are known early, the rest is not eaten */
+    _eaten[0] = 0;
+    capture_reset(&err);
+    earg_feed_begin(&_tree, state, buff, sizeof(buff));
+    CHECK_STATUS(earg_feed(state, "p --bogus a", 11), EARG_USERERROR);
+    CHECK_STATUS(earg_feed(state, " b", 2), EARG_USERERROR);
+    CHECK_STATUS(earg_feed_end(state, NULL), EARG_USERERROR);
+    CHECK_STR(_eaten, "");
+    CHECK_OUTPUT(&err, "p: invalid option -- '--bogus'");
+
+    /* one byte of the buffer is kept for the terminator */
+    capture_reset(&err);
+    earg_feed_begin(&_tree, state, buff, 8);
+    CHECK_STATUS(earg_feed(state, "p abcd", 6), EARG_OK);
+    CHECK_STATUS(earg_feed(state, "e", 1), EARG_OK);
+    CHECK_STATUS(earg_feed(state, "f", 1), EARG_USERERROR);
+    CHECK_STATUS(earg_feed_end(state, NULL), EARG_USERERROR);
+    CHECK_OUTPUT(&err, "line is too long");
+
+    free(state);
+    earg_plan_dispose(&_tree);
+    return TEST_EXIT();
+}
@@ -0,0 +1,163 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include "test.h"
+
+
+/* earg_footprint(), the worst case over the command paths, and the limits
+ * a tree doesn't fit in. */
+
+
+static struct earg_option _options[] = {
+    {"name", 'n', "NAME", 0, "Name"},
+    {"all", 'a', NULL, 0, "All"},
+    {NULL}
+};
+
+
+static struct earg_option _suboptions[] = {
+    {"long", 'l', NULL, 0, "Long"},
+    {"count", 'c', "N", 0, "Count"},
+    {"tag", 't', "TAG", 0, "Tag"},
+    {NULL}
+};
+
+
+static struct earg_option _inneroptions[] = {
+    {"deep", 'd', NULL, 0, "Deep"},
+    {NULL}
+};
+
+
+static struct earg_command _inner = {
+    .name = "inner",
+    .options = _inneroptions,
+};
+
+
+static const struct earg_command *_subcommands[] = {
+    &_inner,
+    NULL
+};
+
+
+static struct earg_command _sub = {
+    .name = "sub",
+    .aliases = (const char *[]) {"s", NULL},
+    .options = _suboptions,
+    .commands = _subcommands,
+};
+
+
+static struct earg_command _other = {
+    .name = "other",
+};
+
+
+static const struct earg_command *_commands[] = {
+    &_sub,
+    &_other,
+    NULL
+};
+
+
+/* --help and --usage are the builtins */
+static struct earg _tree = {
+    .options = _options,
+    .commands = _commands,
+    .flags = EARG_NOELOG,
+};
+
+
+/* one command deeper than the command stack */
+static struct earg_command _chain[CONFIG_EARG_CMDSTACK_MAX];
+static const struct earg_command *_links[CONFIG_EARG_CMDSTACK_MAX][2];
+static struct earg _deeptree = {
+    .commands = _links[0],
+    .flags = EARG_NOELOG,
+};
+
+
+/* one option more than the state holds, along with --help */
+static char _names[CONFIG_EARG_OPTIONS_MAX][8];
+static struct earg_option _many[CONFIG_EARG_OPTIONS_MAX + 1];
+static struct earg _widetree = {
+    .options = _many,
+    .flags = EARG_NOELOG | EARG_NOUSAGE,
+};
+
+
+int
+main() {
+    int i;
+    struct earg_footprint f;
+    size_t perdepth = sizeof(const char *) +
+        sizeof(const struct earg_command *);
+#ifndef CONFIG_EARG_HELP_CACHE
+    struct earg_countingallocator counter;
+#endif
+
+    CHECK(earg_footprint(&_tree, &f) == 0);
+    CHECK(f.options == 8);
+    CHECK(f.depth == 3);
+    CHECK(f.state == earg_state_size());
+    CHECK(f.statemin <= f.state);
+    CHECK(f.tokenizer > 0);
+    CHECK(f.tokenizer < f.state);
+    CHECK(f.optiondb > 0);
+    CHECK(f.optiondb < f.plan);
+
+#ifndef CONFIG_EARG_HELP_CACHE
+    /* all the heap of the plan */
+    _tree.allocator = earg_countingallocator_init(&counter, NULL);
+    CHECK(earg_compile(&_tree) == 0);
+    CHECK(f.plan == counter.current);
+    earg_plan_dispose(&_tree);
+#endif
+
+    for (i = 0; i < CONFIG_EARG_CMDSTACK_MAX; i++) {
+        _chain[i].name = "c";
+        _links[i][0] = _chain + i;
+        if (i) {
+            _chain[i - 1].commands = _links[i];
+        }
+    }
+    CHECK(earg_footprint(&_deeptree, &f) == -1);
+    CHECK(f.depth == (CONFIG_EARG_CMDSTACK_MAX + 1));
+
+    for (i = 0; i < CONFIG_EARG_OPTIONS_MAX; i++) {
+        sprintf(_names[i], "o%d", i);
+        memcpy(_many + i, &(struct earg_option) {_names[i], 256 + i, NULL,
+                0, ""}, sizeof(struct earg_option));
+    }
+    CHECK(earg_footprint(&_widetree, &f) == -1);
+    CHECK(f.options == (CONFIG_EARG_OPTIONS_MAX + 1));
+    CHECK(earg_compile(&_widetree) == -1);
+
+    /* the same without the help */
+    _widetree.flags |= EARG_NOHELP;
+    CHECK(earg_footprint(&_widetree, &f) == 0);
+    CHECK(f.options == CONFIG_EARG_OPTIONS_MAX);
+    CHECK(f.depth == 1);
+    CHECK(f.statemin == (f.state - (CONFIG_EARG_CMDSTACK_MAX - 1) *
+                perdepth));
+    CHECK(earg_compile(&_widetree) == 0);
+    earg_plan_dispose(&_widetree);
+
+    return TEST_EXIT();
+}
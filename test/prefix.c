@@ -0,0 +1,151 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include "test.h"
+
+
+/* EARG_ABBREV, unique prefixes of long options and sub-commands, and the
+ * possibilities listed for an ambiguous one. */
+
+
+static char _eaten[256];
+
+
+static enum earg_eatstatus
+_eat(const struct earg_option *option, const char *value, void *userptr) {
+    size_t len = strlen(_eaten);
+
+    if (option == NULL) {
+        return EARG_EAT_UNRECOGNIZED;
+    }
+
+    snprintf(_eaten + len, sizeof(_eaten) - len, "%c=%s|", option->key,
+            value? value: "");
+    return EARG_EAT_OK;
+}
+
+
+static struct earg_option _options[] = {
+    {"dry-run", 'd', NULL, 0, "Dry run"},
+    {"debug", 'g', NULL, 0, "Debug"},
+    {"name", 'n', "NAME", 0, "Name"},
+    {NULL}
+};
+
+
+static struct earg_command _network = {
+    .name = "network",
+    .aliases = (const char *[]) {"net", "n", NULL},
+    .eat = _eat,
+};
+
+
+static struct earg_command _new = {
+    .name = "new",
+    .eat = _eat,
+};
+
+
+static struct earg_command _status = {
+    .name = "status",
+    .aliases = (const char *[]) {"st", "info", NULL},
+    .eat = _eat,
+};
+
+
+static const struct earg_command *_commands[] = {
+    &_network,
+    &_new,
+    &_status,
+    NULL
+};
+
+
+static struct earg _tree = {
+    .options = _options,
+    .commands = _commands,
+    .eat = _eat,
+    .flags = EARG_NOELOG | EARG_ABBREV,
+};
+
+
+struct testcase {
+    const char *line;
+    enum earg_status status;
+    const struct earg_command *command;
+    const char *eaten;
+};
+
+
+static const struct testcase _cases[] = {
+    {"p --dry", EARG_OK, (struct earg_command *)&_tree, "d=|"},
+    {"p --deb --na=x", EARG_OK, (struct earg_command *)&_tree, "g=|n=x|"},
+    {"p --name x", EARG_OK, (struct earg_command *)&_tree, "n=x|"},
+    {"p netw", EARG_OK, &_network},
+    {"p net", EARG_OK, &_network},
+    {"p n", EARG_OK, &_network},
+    {"p stat", EARG_OK, &_status},
+
+    /* the name and an alias of the same command */
+    {"p st", EARG_OK, &_status},
+    {"p in", EARG_OK, &_status},
+    {"p new --d", EARG_USERERROR},
+    {"p --bogus", EARG_USERERROR},
+};
+
+
+#define CASES (sizeof(_cases) / sizeof(_cases[0]))
+
+
+int
+main() {
+    int i;
+    struct capture out;
+    struct capture err;
+    const struct earg_command *command;
+    earg_state_t state = test_state(&out, &err);
+
+    CHECK(earg_compile(&_tree) == 0);
+    for (i = 0; i < CASES; i++) {
+        command = NULL;
+        _eaten[0] = 0;
+        CHECK_STATUS(test_parse(&_tree, state, &out, &err, _cases[i].line,
+                    &command), _cases[i].status);
+        if (_cases[i].status != EARG_OK) {
+            continue;
+        }
+
+        CHECK(command == _cases[i].command);
+        if (_cases[i].eaten) {
+            CHECK_STR(_eaten, _cases[i].eaten);
+        }
+    }
+
+    /* each command is listed once, by the name if it matches */
+    test_parse(&_tree, state, &out, &err, "p ne", NULL);
+    CHECK_OUTPUT(&err, "ambiguous command -- 'ne', possibilities: "
+            "'network' 'new'\n");
+
+    test_parse(&_tree, state, &out, &err, "p --d", NULL);
+    CHECK_OUTPUT(&err, "ambiguous option -- '--d', possibilities: "
+            "'--debug' '--dry-run'\n");
+
+    free(state);
+    earg_plan_dispose(&_tree);
+    return TEST_EXIT();
+}
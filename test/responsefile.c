@@ -0,0 +1,164 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include "test.h"
+
+
+/* @path arguments, read from response files, nested up to
+ * CONFIG_EARG_RESPONSEFILE_DEPTH deep. */
+
+
+static char _eaten[256];
+
+
+static enum earg_eatstatus
+_eat(const struct earg_option *option, const char *value, void *userptr) {
+    size_t len = strlen(_eaten);
+
+    snprintf(_eaten + len, sizeof(_eaten) - len, "%s%c=%s|",
+            option? "-": "", option? option->key: 'p', value? value: "");
+    return EARG_EAT_OK;
+}
+
+
+static struct earg_option _options[] = {
+    {"name", 'n', "NAME", 0, "Name"},
+    {"all", 'a', NULL, 0, "All"},
+    {NULL}
+};
+
+
+static struct earg_command _sub = {
+    .name = "sub",
+    .args = "[WORD...]",
+    .eat = _eat,
+};
+
+
+static const struct earg_command *_commands[] = {
+    &_sub,
+    NULL
+};
+
+
+static struct earg _tree = {
+    .options = _options,
+    .commands = _commands,
+    .args = "[WORD...]",
+    .eat = _eat,
+    .flags = EARG_NOELOG | EARG_RESPONSEFILE,
+};
+
+
+struct testcase {
+    const char *line;
+    enum earg_status status;
+    const char *expected;
+};
+
+
+static const struct testcase _cases[] = {
+    {"p @name.rsp", EARG_OK, "-n=x y|"},
+    {"p @name.rsp -a", EARG_OK, "-n=x y|-a=|"},
+    {"p @sub.rsp w", EARG_OK, "-a=|p=a b|p=c|p=w|"},
+    {"p @nested.rsp", EARG_OK, "-a=|-n=x y|p=z|"},
+    {"p @empty.rsp -a", EARG_OK, "-a=|"},
+
+    /* the limit */
+    {"p @depth1.rsp", EARG_OK, "-a=|"},
+    {"p @loop.rsp", EARG_USERERROR},
+    {"p @missing.rsp", EARG_USERERROR},
+    {"p @quote.rsp", EARG_USERERROR},
+
+    /* not response files */
+    {"p @", EARG_OK, "p=@|"},
+    {"p -- @name.rsp", EARG_OK, "p=@name.rsp|"},
+    {"p --name=@name.rsp", EARG_OK, "-n=@name.rsp|"},
+};
+
+
+#define CASES (sizeof(_cases) / sizeof(_cases[0]))
+
+
+int
+main() {
+    int i;
+    char path[32];
+    char contents[64];
+    struct capture out;
+    struct capture err;
+    earg_state_t state = test_state(&out, &err);
+    const char *argv[] = {"p", "@sub.rsp", "-n", "x"};
+
+    test_write("name.rsp", "--name 'x y'\n");
+    test_write("sub.rsp", "-a\nsub \"a b\" \\\n c\n");
+    test_write("nested.rsp", "-a @name.rsp\nz");
+    test_write("empty.rsp", "");
+    test_write("loop.rsp", "@loop.rsp");
+    test_write("quote.rsp", "'x");
+
+    /* depth1.rsp includes depth2.rsp and so on, the last one has -a */
+    for (i = 1; i <= CONFIG_EARG_RESPONSEFILE_DEPTH + 1; i++) {
+        sprintf(path, "depth%d.rsp", i);
+        sprintf(contents, "@depth%d.rsp", i + 1);
+        test_write(path, contents);
+    }
+    sprintf(path, "depth%d.rsp", CONFIG_EARG_RESPONSEFILE_DEPTH);
+    test_write(path, "-a");
+
+    CHECK(earg_compile(&_tree) == 0);
+    for (i = 0; i < CASES; i++) {
+        _eaten[0] = 0;
+        CHECK_STATUS(test_parse(&_tree, state, &out, &err, _cases[i].line,
+                    NULL), _cases[i].status);
+        if (_cases[i].expected) {
+            CHECK_STR(_eaten, _cases[i].expected);
+        }
+    }
+
+    /* one more level */
+    sprintf(path, "depth%d.rsp", CONFIG_EARG_RESPONSEFILE_DEPTH);
+    sprintf(contents, "@depth%d.rsp", CONFIG_EARG_RESPONSEFILE_DEPTH + 1);
+    test_write(path, contents);
+    sprintf(path, "depth%d.rsp", CONFIG_EARG_RESPONSEFILE_DEPTH + 1);
+    test_write(path, "-a");
+    CHECK_STATUS(test_parse(&_tree, state, &out, &err, "p @depth1.rsp",
+                NULL), EARG_USERERROR);
+    sprintf(contents, "nested too deep -- '@depth%d.rsp'\n",
+            CONFIG_EARG_RESPONSEFILE_DEPTH + 1);
+    CHECK_OUTPUT(&err, contents);
+
+    test_parse(&_tree, state, &out, &err, "p @missing.rsp", NULL);
+    CHECK_OUTPUT(&err, "p: cannot read response file -- '@missing.rsp': ");
+
+    /* argv too */
+    _eaten[0] = 0;
+    CHECK_STATUS(earg_parse_r(&_tree, state, 4, argv, NULL), EARG_OK);
+    CHECK_STR(_eaten, "-a=|p=a b|p=c|-n=x|");
+
+    /* off, @path is a plain argument */
+    _tree.flags &= ~EARG_RESPONSEFILE;
+    _eaten[0] = 0;
+    CHECK_STATUS(test_parse(&_tree, state, &out, &err, "p @name.rsp", NULL),
+            EARG_OK);
+    CHECK_STR(_eaten, "p=@name.rsp|");
+
+    free(state);
+    earg_plan_dispose(&_tree);
+    return TEST_EXIT();
+}
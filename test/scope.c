@@ -0,0 +1,167 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include "test.h"
+
+
+/* Each command has its own option scope, the innermost wins on a name or
+ * key clash. With EARG_SCOPED only the inherited options and the builtins
+ * of the parents are visible. */
+
+
+static char _eaten[256];
+
+
+/* the userptr is the name of the command */
+static enum earg_eatstatus
+_eat(const struct earg_option *option, const char *value, void *userptr) {
+    size_t len = strlen(_eaten);
+
+    if (option == NULL) {
+        return EARG_EAT_UNRECOGNIZED;
+    }
+
+    snprintf(_eaten + len, sizeof(_eaten) - len, "%s:%c=%s|",
+            (const char *)userptr, option->key, value? value: "");
+    return EARG_EAT_OK;
+}
+
+
+static struct earg_option _options[] = {
+    {"name", 'n', "NAME", 0, "Name"},
+    {"all", 'a', NULL, 0, "All"},
+    {"global", 'g', NULL, EARG_OPTION_INHERITED, "Global"},
+    {NULL}
+};
+
+
+/* shadows --name and -a of the root */
+static struct earg_option _suboptions[] = {
+    {"name", 'm', "NAME", 0, "Name"},
+    {"long", 'a', NULL, 0, "Long"},
+    {NULL}
+};
+
+
+static struct earg_command _inner = {
+    .name = "inner",
+    .eat = _eat,
+    .userptr = "inner",
+};
+
+
+static const struct earg_command *_subcommands[] = {
+    &_inner,
+    NULL
+};
+
+
+static struct earg_command _sub = {
+    .name = "sub",
+    .options = _suboptions,
+    .commands = _subcommands,
+    .eat = _eat,
+    .userptr = "sub",
+};
+
+
+static const struct earg_command *_commands[] = {
+    &_sub,
+    NULL
+};
+
+
+static struct earg _tree = {
+    .options = _options,
+    .commands = _commands,
+    .eat = _eat,
+    .userptr = "root",
+    .flags = EARG_NOELOG,
+};
+
+
+static struct earg _scopedtree = {
+    .options = _options,
+    .commands = _commands,
+    .eat = _eat,
+    .userptr = "root",
+    .flags = EARG_SCOPED,
+};
+
+
+struct testcase {
+    const struct earg *tree;
+    const char *line;
+    enum earg_status status;
+    const char *expected;
+};
+
+
+static const struct testcase _cases[] = {
+    {&_tree, "p -n x -a sub", EARG_OK, "root:n=x|root:a=|"},
+    {&_tree, "p sub --name y -a", EARG_OK, "sub:m=y|sub:a=|"},
+    {&_tree, "p sub -n y", EARG_OK, "root:n=y|"},
+    {&_tree, "p -a sub -a", EARG_OK, "root:a=|sub:a=|"},
+    {&_tree, "p sub -g inner -a --name z", EARG_OK,
+        "root:g=|sub:a=|sub:m=z|"},
+    {&_tree, "p sub inner --all", EARG_OK, "root:a=|"},
+
+    /* the same option of the root, given twice */
+    {&_tree, "p -n x sub -n y", EARG_USERERROR},
+
+    /* the root's options are not visible to the sub-commands */
+    {&_scopedtree, "p -n x -a sub", EARG_OK, "root:n=x|root:a=|"},
+    {&_scopedtree, "p sub --name y -a", EARG_OK, "sub:m=y|sub:a=|"},
+    {&_scopedtree, "p sub -n y", EARG_USERERROR},
+    {&_scopedtree, "p sub --all", EARG_USERERROR},
+    {&_scopedtree, "p sub inner --all", EARG_USERERROR},
+    {&_scopedtree, "p sub inner --name z", EARG_USERERROR},
+
+    /* inherited ones and the builtins are */
+    {&_scopedtree, "p sub -g", EARG_OK, "root:g=|"},
+    {&_scopedtree, "p sub inner --global", EARG_OK, "root:g=|"},
+    {&_scopedtree, "p sub inner --help", EARG_OK_EXIT},
+};
+
+
+#define CASES (sizeof(_cases) / sizeof(_cases[0]))
+
+
+int
+main() {
+    int i;
+    struct capture out;
+    struct capture err;
+    earg_state_t state = test_state(&out, &err);
+
+    CHECK(earg_compile(&_tree) == 0);
+    CHECK(earg_compile(&_scopedtree) == 0);
+    for (i = 0; i < CASES; i++) {
+        _eaten[0] = 0;
+        CHECK_STATUS(test_parse(_cases[i].tree, state, &out, &err,
+                    _cases[i].line, NULL), _cases[i].status);
+        if (_cases[i].expected) {
+            CHECK_STR(_eaten, _cases[i].expected);
+        }
+    }
+
+    free(state);
+    earg_plan_dispose(&_tree);
+    earg_plan_dispose(&_scopedtree);
+    return TEST_EXIT();
+}
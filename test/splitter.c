@@ -0,0 +1,139 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include "test.h"
+
+
+/* earg_parse_line() splits the line in place, like a shell does. */
+
+
+#define WORDSMAX 8
+
+
+struct words {
+    int count;
+    const char *values[WORDSMAX];
+};
+
+
+static struct words _words;
+
+
+static enum earg_eatstatus
+_eat(const struct earg_option *option, const char *value, void *userptr) {
+    struct words *w = userptr;
+
+    if (w->count == WORDSMAX) {
+        return EARG_EAT_INVALID;
+    }
+
+    w->values[w->count++] = value;
+    return EARG_EAT_OK;
+}
+
+
+static struct earg_option _options[] = {
+    {"name", 'n', "NAME", EARG_OPTION_MULTIPLE, "Name"},
+    {NULL}
+};
+
+
+static struct earg _tree = {
+    .options = _options,
+    .args = "[WORD...]",
+    .eat = _eat,
+    .userptr = &_words,
+    .flags = EARG_NOELOG,
+};
+
+
+struct testcase {
+    const char *line;
+    enum earg_status status;
+
+    /* the words eaten, NULL terminated */
+    const char *words[WORDSMAX];
+};
+
+
+static const struct testcase _cases[] = {
+    {"p", EARG_OK, {NULL}},
+    {"p a b", EARG_OK, {"a", "b", NULL}},
+    {"  p \t a  \t\t b   ", EARG_OK, {"a", "b", NULL}},
+    {"p a\nb", EARG_OK, {"a", "b", NULL}},
+    {"p 'a b' \"c d\"", EARG_OK, {"a b", "c d", NULL}},
+    {"p a\\ b", EARG_OK, {"a b", NULL}},
+    {"p a\"b\"'c'd", EARG_OK, {"abcd", NULL}},
+    {"p 'a\\b' 'c\"d'", EARG_OK, {"a\\b", "c\"d", NULL}},
+    {"p \"a\\\"b\" \"c\\\\d\" \"e\\f\"", EARG_OK,
+        {"a\"b", "c\\d", "e\\f", NULL}},
+    {"p \"a'b\" \\'", EARG_OK, {"a'b", "'", NULL}},
+    {"p a\\\nb", EARG_OK, {"ab", NULL}},
+    {"p \"a\\\nb\"", EARG_OK, {"a\\\nb", NULL}},
+    {"p --name='x y' -n \"z w\" -n'v'", EARG_OK, {"x y", "z w", "v", NULL}},
+    {"p -- '-a' \"--b\"", EARG_OK, {"-a", "--b", NULL}},
+    {"p 'a", EARG_USERERROR, {NULL}},
+    {"p \"a", EARG_USERERROR, {NULL}},
+    {"p a\\", EARG_USERERROR, {NULL}},
+};
+
+
+#define CASES (sizeof(_cases) / sizeof(_cases[0]))
+
+
+int
+main() {
+    int i;
+    int j;
+    char line[64];
+    struct capture out;
+    struct capture err;
+    enum earg_status status;
+    earg_state_t state = test_state(&out, &err);
+
+    CHECK(earg_compile(&_tree) == 0);
+    for (i = 0; i < CASES; i++) {
+        _words.count = 0;
+        capture_reset(&err);
+        strcpy(line, _cases[i].line);
+        status = earg_parse_line(&_tree, state, line, NULL);
+        CHECK_STATUS(status, _cases[i].status);
+        if (status != EARG_OK) {
+            CHECK_OUTPUT(&err, "p: unterminated quote or escape");
+            continue;
+        }
+
+        for (j = 0; _cases[i].words[j]; j++) {
+            CHECK(j < _words.count);
+            if (j >= _words.count) {
+                break;
+            }
+
+            CHECK_STR(_words.values[j], _cases[i].words[j]);
+
+            /* in place */
+            CHECK((_words.values[j] >= line) &&
+                    (_words.values[j] < (line + sizeof(line))));
+        }
+        CHECK(j == _words.count);
+    }
+
+    free(state);
+    earg_plan_dispose(&_tree);
+    return TEST_EXIT();
+}
@@ -0,0 +1,127 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include "test.h"
+
+
+/* Counters of each parse, and their sums over many parses. Without
+ * CONFIG_EARG_STATS there are none. */
+
+
+static enum earg_eatstatus
+_eat(const struct earg_option *option, const char *value, void *userptr) {
+    return EARG_EAT_OK;
+}
+
+
+static struct earg_option _options[] = {
+    {"name", 'n', "NAME", 0, "Name"},
+    {"all", 'a', NULL, 0, "All"},
+    {NULL}
+};
+
+
+static struct earg_command _sub = {
+    .name = "sub",
+    .args = "[WORD...]",
+    .eat = _eat,
+};
+
+
+static const struct earg_command *_commands[] = {
+    &_sub,
+    NULL
+};
+
+
+static struct earg _tree = {
+    .options = _options,
+    .commands = _commands,
+    .eat = _eat,
+    .flags = EARG_NOELOG,
+};
+
+
+int
+main() {
+    struct capture out;
+    struct capture err;
+    earg_state_t state = test_state(&out, &err);
+    const struct earg_stats *stats;
+#ifdef CONFIG_EARG_STATS
+    struct earg_statsaggregate aggregate = {0};
+    const char *argv[] = {"p", "-a"};
+#endif
+
+    CHECK(earg_compile(&_tree) == 0);
+
+#ifdef CONFIG_EARG_STATS
+    CHECK(earg_state_aggregate(state, &aggregate) == 0);
+    CHECK_STATUS(test_parse(&_tree, state, &out, &err, "p -an x sub y z",
+                NULL), EARG_OK);
+    stats = earg_state_stats(state);
+    CHECK(stats != NULL);
+    CHECK(stats->tokens >= 5);
+    CHECK(stats->probes >= 2);
+    CHECK(stats->lookups >= 1);
+    CHECK(stats->eats == 4);
+    CHECK(stats->ns >= stats->eatns);
+    CHECK(stats->heap == 0);
+    CHECK(stats->depth == 2);
+    CHECK(stats->command == &_sub);
+
+    CHECK_STATUS(test_parse(&_tree, state, &out, &err, "p --bogus", NULL),
+            EARG_USERERROR);
+    CHECK(stats->eats == 0);
+    CHECK(stats->depth == 1);
+    CHECK(stats->command == (struct earg_command *)&_tree);
+
+    CHECK_STATUS(test_parse(&_tree, state, &out, &err, "p -a", NULL),
+            EARG_OK);
+    CHECK(stats->eats == 1);
+
+    CHECK(aggregate.calls == 3);
+    CHECK(aggregate.failures == 1);
+    CHECK(aggregate.total.eats == 5);
+    CHECK(aggregate.total.depth == 2);
+    CHECK(aggregate.slowest.ns <= aggregate.total.ns);
+
+    /* stopped */
+    CHECK(earg_state_aggregate(state, NULL) == 0);
+    test_parse(&_tree, state, &out, &err, "p", NULL);
+    CHECK(aggregate.calls == 3);
+
+    /* earg_parse() counts the heap of the state it allocates */
+    earg_plan_dispose(&_tree);
+    CHECK_STATUS(earg_parse(&_tree, 2, argv, NULL), EARG_OK);
+    stats = earg_state_stats(_tree.state);
+    CHECK(stats->heap >= earg_state_size());
+    CHECK(stats->eats == 1);
+    earg_dispose(&_tree);
+#else
+    CHECK_STATUS(test_parse(&_tree, state, &out, &err, "p -a", NULL),
+            EARG_OK);
+    stats = earg_state_stats(state);
+    CHECK(stats == NULL);
+    CHECK(earg_state_aggregate(state, NULL) == -1);
+    earg_plan_dispose(&_tree);
+#endif
+
+    free(state);
+    return TEST_EXIT();
+}
@@ -0,0 +1,141 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#include "test.h"
+
+
+/* The closest long option or sub-command is suggested for a mistyped
+ * one, nothing if none is close enough. */
+
+
+static enum earg_eatstatus
+_eat(const struct earg_option *option, const char *value, void *userptr) {
+    return option? EARG_EAT_OK: EARG_EAT_UNRECOGNIZED;
+}
+
+
+static struct earg_option _options[] = {
+    {"dry-run", 'd', NULL, 0, "Dry run"},
+    {"output", 'o', "FILE", 0, "Output"},
+    {NULL}
+};
+
+
+static struct earg_option _showoptions[] = {
+    {"long", 'l', NULL, 0, "Long"},
+    {NULL}
+};
+
+
+static struct earg_command _show = {
+    .name = "show",
+    .options = _showoptions,
+    .eat = _eat,
+};
+
+
+static const struct earg_command *_netcommands[] = {
+    &_show,
+    NULL
+};
+
+
+static struct earg_command _network = {
+    .name = "network",
+    .aliases = (const char *[]) {"net", NULL},
+    .commands = _netcommands,
+    .eat = _eat,
+};
+
+
+static struct earg_command _status = {
+    .name = "status",
+    .eat = _eat,
+};
+
+
+static const struct earg_command *_commands[] = {
+    &_network,
+    &_status,
+    NULL
+};
+
+
+static struct earg _tree = {
+    .options = _options,
+    .commands = _commands,
+    .eat = _eat,
+    .flags = EARG_NOELOG,
+};
+
+
+struct testcase {
+    const char *line;
+    const char *suggestion;
+};
+
+
+static const struct testcase _cases[] = {
+    {"p --dry-rnu", "Did you mean '--dry-run'?\n"},
+    {"p --outptu=x", "Did you mean '--output'?\n"},
+    {"p --dryrun", "Did you mean '--dry-run'?\n"},
+    {"p netwrok", "Did you mean 'network'?\n"},
+    {"p stauts", "Did you mean 'status'?\n"},
+    {"p net shw", "Did you mean 'show'?\n"},
+    {"p net show --lonng", "Did you mean '--long'?\n"},
+
+    /* the parents' options are visible to the sub-commands */
+    {"p net show --ouptut x", "Did you mean '--output'?\n"},
+
+    /* too far, or too short to guess, a swap counts as two edits */
+    {"p --bogus", NULL},
+    {"p --x", NULL},
+    {"p nothing", NULL},
+    {"p net --lonng", NULL},
+    {"p net shwo", NULL},
+};
+
+
+#define CASES (sizeof(_cases) / sizeof(_cases[0]))
+
+
+int
+main() {
+    int i;
+    struct capture out;
+    struct capture err;
+    earg_state_t state = test_state(&out, &err);
+
+    CHECK(earg_compile(&_tree) == 0);
+    for (i = 0; i < CASES; i++) {
+        CHECK_STATUS(test_parse(&_tree, state, &out, &err, _cases[i].line,
+                    NULL), EARG_USERERROR);
+        if (_cases[i].suggestion) {
+            CHECK_OUTPUT(&err, _cases[i].suggestion);
+        }
+        else if (strstr(err.buff, "Did you mean")) {
+            fprintf(stderr, "'%s': unexpected suggestion: %s",
+                    _cases[i].line, err.buff);
+            _failures++;
+        }
+    }
+
+    free(state);
+    earg_plan_dispose(&_tree);
+    return TEST_EXIT();
+}
@@ -0,0 +1,159 @@
+// Copyright 2023 Vahid Mardani
+/*
+ * This file is part of earg.
+ *  earg is free software: you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation, either version 3 of the License, or (at your option)
+ *  any later version.
+ *
+ *  earg is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with earg. If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Author: Vahid Mardani <vahid.mardani@gmail.com>
+ */
+#ifndef TEST_H_
+#define TEST_H_
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "earg.h"
+
+
+/* Helpers shared by the tests, each test is a single translation unit
+ * and a ctest of its own. */
+
+
+static int _failures;
+
+
+#define CHECK(c) do { \
+        if (!(c)) { \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, #c); \
+            _failures++; \
+        } \
+    } while (0)
+
+
+#define CHECK_STATUS(s, e) do { \
+        enum earg_status __s = (s); \
+        if (__s != (e)) { \
+            fprintf(stderr, "%s:%d: %s: %d, expected %d\n", __FILE__, \
+                    __LINE__, #s, __s, e); \
+            _failures++; \
+        } \
+    } while (0)
+
+
+#define CHECK_STR(a, b) do { \
+        const char *__a = (a); \
+        const char *__b = (b); \
+        if ((__a == NULL) || (__b == NULL) || strcmp(__a, __b)) { \
+            fprintf(stderr, "%s:%d: %s: '%s', expected '%s'\n", __FILE__, \
+                    __LINE__, #a, __a? __a: "(null)", __b? __b: "(null)"); \
+            _failures++; \
+        } \
+    } while (0)
+
+
+/* strstr() over the captured output */
+#define CHECK_OUTPUT(cap, s) do { \
+        if (strstr((cap)->buff, s) == NULL) { \
+            fprintf(stderr, "%s:%d: '%s' is not in:\n%s\n", __FILE__, \
+                    __LINE__, s, (cap)->buff); \
+            _failures++; \
+        } \
+    } while (0)
+
+
+#define TEST_EXIT() \
+    (printf("%s: %d failures\n", __FILE__, _failures), \
+     _failures? EXIT_FAILURE: EXIT_SUCCESS)
+
+
+/* A sink which keeps everything written to it, NUL terminated */
+struct capture {
+    char buff[2048];
+    size_t len;
+};
+
+
+static int
+capture_write(void *ptr, const char *data, size_t len) {
+    struct capture *c = ptr;
+
+    if (len >= (sizeof(c->buff) - c->len)) {
+        len = sizeof(c->buff) - c->len - 1;
+    }
+
+    memcpy(c->buff + c->len, data, len);
+    c->len += len;
+    c->buff[c->len] = 0;
+    return 0;
+}
+
+
+static void
+capture_reset(struct capture *c) {
+    c->len = 0;
+    c->buff[0] = 0;
+}
+
+
+/* A state on the heap, its output and diagnostics go to the captures */
+static earg_state_t
+test_state(struct capture *out, struct capture *err) {
+    earg_state_t state;
+    struct earg_sink o = {.write = capture_write, .ptr = out};
+    struct earg_sink e = {.write = capture_write, .ptr = err};
+
+    state = earg_state_init(malloc(earg_state_size()), earg_state_size());
+    if (state == NULL) {
+        fprintf(stderr, "cannot allocate the state\n");
+        exit(EXIT_FAILURE);
+    }
+
+    capture_reset(out);
+    capture_reset(err);
+    earg_state_sinks(state, &o, &e);
+    return state;
+}
+
+
+/* Fixture files are written in the test's build directory */
+static void
+test_write(const char *path, const char *contents) {
+    FILE *f = fopen(path, "w");
+
+    if (f == NULL) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+
+    fputs(contents, f);
+    fclose(f);
+}
+
+
+/* Parse a copy of the line, the captures are cleared first */
+static enum earg_status
+test_parse(const struct earg *c, earg_state_t state, struct capture *out,
+        struct capture *err, const char *line,
+        const struct earg_command **command) {
+    static char buff[1024];
+
+    capture_reset(out);
+    capture_reset(err);
+    strncpy(buff, line, sizeof(buff) - 1);
+    return earg_parse_line(c, state, buff, command);
+}
+
+
+#endif  // TEST_H_
@@ -17,37 +17,28 @@
  *  Author: Vahid Mardani <vahid.mardani@gmail.com>
  */
 #include <stdbool.h>
-#include <stdlib.h>
-#include <errno.h>
+#include <stdint.h>
 #include <string.h>
+#include <errno.h>
 
 #include "option.h"
+#include "stats.h"
 #include "tokenizer.h"
 
 
-struct tokenizer {
-    const struct optiondb *optiondb;
-    int argc;
-    const char **argv;
-
-    /* tokenizer state */
-    int line;
-    int w;
-    int c;
-    int toklen;
-    const char *tok;
-    struct optioninfo *optioninfo;
-    bool dashdash;
-};
+/* Coroutine  stuff*/
+#define CLASSIFICATION() \
+        token->arglen = t->toklen; \
+        token->eq = t->eq; \
+        token->dashes = t->dashes
 
 
-/* Coroutine  stuff*/
 #define YIELD_OPT(opt, v, l) do { \
-        opt->occurances++; \
         t->line = __LINE__; \
         token->text = v; \
         token->len = l; \
         token->optioninfo = opt; \
+        CLASSIFICATION(); \
         return EARG_TOK_OPTION; \
         case __LINE__:; \
     } while (0)
@@ -58,26 +49,62 @@ struct tokenizer {
         token->text = tok; \
         token->len = l; \
         token->optioninfo = NULL; \
+        CLASSIFICATION(); \
         return EARG_TOK_UNKNOWN; \
         case __LINE__:; \
     } while (0)
 
 
+#define YIELD_OPT_AMBIGUOUS(tok, l) do { \
+        t->line = __LINE__; \
+        token->text = tok; \
+        token->len = l; \
+        token->optioninfo = NULL; \
+        CLASSIFICATION(); \
+        return EARG_TOK_AMBIGUOUS; \
+        case __LINE__:; \
+    } while (0)
+
+
+#define YIELD_RESPONSEFILE_FAILED(tok, l) do { \
+        t->line = __LINE__; \
+        token->text = tok; \
+        token->len = l; \
+        token->optioninfo = NULL; \
+        CLASSIFICATION(); \
+        return EARG_TOK_RESPONSEFILE; \
+        case __LINE__:; \
+    } while (0)
+
+
 #define YIELD_POS(v, l) do { \
         t->line = __LINE__; \
         token->text = v; \
         token->len = l; \
         token->optioninfo = NULL; \
+        CLASSIFICATION(); \
         return EARG_TOK_POSITIONAL; \
         case __LINE__:; \
     } while (0)
 
 
+#define YIELD_MORE() do { \
+        t->line = __LINE__; \
+        token->text = NULL; \
+        token->len = 0; \
+        token->optioninfo = NULL; \
+        token->arglen = 0; \
+        return EARG_TOK_MORE; \
+        case __LINE__:; \
+    } while (0)
+
+
 #define REJECT \
     t->line = -1; \
     token->text = NULL; \
     token->len = 0; \
     token->optioninfo = NULL; \
+    token->arglen = 0; \
     return EARG_TOK_ERROR
 
 
@@ -86,6 +113,7 @@ struct tokenizer {
     token->text = NULL; \
     token->len = 0; \
     token->optioninfo = NULL; \
+    token->arglen = 0; \
     return EARG_TOK_END
 
 
@@ -93,47 +121,205 @@ struct tokenizer {
     case -1: REJECT; case 0:
 
 
-struct tokenizer *
-tokenizer_new(int argc, const char **argv,
-        const struct optiondb *optdb) {
-    struct tokenizer *t = malloc(sizeof(struct tokenizer));
-    if (t == NULL) {
-        return NULL;
+/* word-at-a-time helpers */
+typedef size_t __attribute__((__may_alias__)) word_t;
+#define ONES ((size_t)-1 / 0xFF)
+#define HIGHS (ONES * 0x80)
+#define EQS (ONES * '=')
+#define HASZERO(v) (((v) - ONES) & ~(v) & HIGHS)
+
+
+/* Finds the length, the first '=' and the dash prefix of the current
+ * argument. Whole aligned words inside the argument are skipped while
+ * they contain no '=', the rest is scanned a byte at a time, nothing
+ * past the terminator is read. */
+static void
+_classify(struct tokenizer *t) {
+    const char *p = t->tok;
+    const char *end = p + strlen(p);
+    const word_t *w;
+
+    t->eq = -1;
+    for (; p < end; p++) {
+        if ((((uintptr_t)p) % sizeof(word_t)) == 0) {
+            w = (const word_t *)p;
+            while (((const char *)(w + 1) <= end) && (!HASZERO(*w ^ EQS))) {
+                w++;
+            }
+
+            p = (const char *)w;
+            if (p == end) {
+                break;
+            }
+        }
+
+        if (*p == '=') {
+            t->eq = p - t->tok;
+            break;
+        }
+    }
+
+    t->toklen = end - t->tok;
+    t->dashes = 0;
+    if (t->tok[0] == '-') {
+        t->dashes = (t->tok[1] == '-')? 2: 1;
     }
+}
+
 
+void
+tokenizer_init(struct tokenizer *t, int argc, const char **argv,
+        const struct optiondb *optdb) {
     t->line = 0;
     t->optiondb = optdb;
     t->argc = argc;
     t->argv = argv;
+    t->w = 0;
     t->dashdash = false;
-    return t;
+    t->abbrev = false;
+#ifdef CONFIG_EARG_STATS
+    t->probes = 0;
+#endif
+#if CONFIG_EARG_RESPONSEFILE_DEPTH
+    t->responsefiles = false;
+    t->depth = 0;
+    t->files = NULL;
+    t->allocator = NULL;
+    t->error = 0;
+#endif
+}
+
+
+void
+tokenizer_initline(struct tokenizer *t, char *line, size_t len,
+        size_t size, bool eol, const struct optiondb *optdb) {
+    tokenizer_init(t, 0, NULL, optdb);
+    splitter_init(&t->splitter, line, len, size, eol);
+}
+
+
+#if CONFIG_EARG_RESPONSEFILE_DEPTH
+
+/* t->tok is @path, split the file before the rest of the source */
+static int
+_responsefile_push(struct tokenizer *t) {
+    struct responsefile *f;
+
+    if (t->depth == CONFIG_EARG_RESPONSEFILE_DEPTH) {
+        t->error = 0;
+        return -1;
+    }
+
+    f = responsefile_open(t->tok + 1, t->allocator);
+    if (f == NULL) {
+        t->error = errno;
+        return -1;
+    }
+
+    f->next = t->files;
+    t->files = f;
+    splitter_init(&t->responses[t->depth++], f->buff, f->len, f->len + 1,
+            true);
+    return 0;
 }
 
 
 void
 tokenizer_dispose(struct tokenizer *t) {
-    if (t == NULL) {
-        return;
+    struct responsefile *f;
+
+    while (t->files) {
+        f = t->files;
+        t->files = f->next;
+        responsefile_close(f, t->allocator);
+    }
+    t->depth = 0;
+}
+
+#endif
+
+
+/* fetch the next argument from the source into t->tok */
+static enum splitter_status
+_fetch(struct tokenizer *t) {
+    char *word;
+    enum splitter_status status;
+
+#if CONFIG_EARG_RESPONSEFILE_DEPTH
+    while (t->depth) {
+        status = splitter_next(&t->responses[t->depth - 1], &word);
+        if (status == SPLITTER_END) {
+            t->depth--;
+            continue;
+        }
+
+        if (status == SPLITTER_WORD) {
+            t->tok = word;
+        }
+        return status;
+    }
+#endif
+
+    if (t->argv) {
+        if (t->w >= t->argc) {
+            return SPLITTER_END;
+        }
+
+        t->tok = t->argv[t->w++];
+        return t->tok? SPLITTER_WORD: SPLITTER_ERROR;
+    }
+
+    status = splitter_next(&t->splitter, &word);
+    if (status == SPLITTER_WORD) {
+        t->tok = word;
     }
 
-    free(t);
+    return status;
+}
+
+
+void
+tokenizer_optiondb(struct tokenizer *t, const struct optiondb *optdb) {
+    t->optiondb = optdb;
 }
 
 
 enum tokenizer_status
 tokenizer_next(struct tokenizer *t, struct token *token) {
-    const char *eq;
+    enum splitter_status status;
+    int namelen;
+    int matches;
 
     START;
-    for (t->w = 0; t->w < t->argc; t->w++) {
-        t->tok = t->argv[t->w];
-        t->optioninfo = NULL;
+    for (;;) {
+        status = _fetch(t);
+        if (status == SPLITTER_END) {
+            break;
+        }
 
-        if (t->tok == NULL) {
+        /* wait for the caller to feed more bytes */
+        if (status == SPLITTER_MORE) {
+            YIELD_MORE();
+            continue;
+        }
+
+        if (status != SPLITTER_WORD) {
             REJECT;
         }
+        t->optioninfo = NULL;
 
-        t->toklen = strlen(t->tok);
+#if CONFIG_EARG_RESPONSEFILE_DEPTH
+        /* @path, the arguments are read from the file */
+        if (t->responsefiles && (!t->dashdash) && (t->tok[0] == '@') &&
+                t->tok[1]) {
+            if (_responsefile_push(t)) {
+                YIELD_RESPONSEFILE_FAILED(t->tok, strlen(t->tok));
+            }
+            continue;
+        }
+#endif
+
+        _classify(t);
         if (t->toklen == 0) {
             continue;
         }
@@ -143,43 +329,53 @@ tokenizer_next(struct tokenizer *t, struct token *token) {
         }
 
         /* double dashes */
-        if ((t->tok[0] == '-') && (t->tok[1] == '-')) {
+        if (t->dashes == 2) {
             /* threat the rest of tokens as positional arguments */
             if (t->toklen == 2) {
                 t->dashdash = true;
                 continue;
             }
 
-            /* flag or option? '-foo' or '--foo=bar' */
-            eq = strchr(t->tok, '=');
-
-            /* Left side length */
-            if ((t->toklen == 3) || (eq && ((eq - t->tok) == 3))) {
+            /* Left side length, flag or option? '--foo' or '--foo=bar' */
+            if (((t->toklen == 3) || (t->eq == 3)) && (!t->abbrev)) {
                 YIELD_OPT_UNKNOWN(t->tok, t->toklen);
                 continue;
             }
 
-            // TODO: check the rightside len
+            namelen = ((t->eq >= 0)? t->eq: t->toklen) - 2;
+            STATS_INC(t, probes);
             t->optioninfo = optiondb_findbyname(t->optiondb, t->tok + 2,
-                    (eq? eq - t->tok: t->toklen) - 2);
+                    namelen);
+
+            if ((t->optioninfo == NULL) && t->abbrev) {
+                STATS_INC(t, probes);
+                t->optioninfo = optiondb_findbyprefix(t->optiondb,
+                        t->tok + 2, namelen, &matches);
+                if (matches > 1) {
+                    YIELD_OPT_AMBIGUOUS(t->tok, namelen + 2);
+                    continue;
+                }
+            }
 
             if (t->optioninfo == NULL) {
                 YIELD_OPT_UNKNOWN(t->tok, t->toklen);
                 continue;
             }
 
-            if (!eq) {
+            if (t->eq < 0) {
                 YIELD_OPT(t->optioninfo, NULL, 0);
                 continue;
             }
 
-            YIELD_OPT(t->optioninfo, eq+1, strlen(eq+1));
+            YIELD_OPT(t->optioninfo, t->tok + t->eq + 1,
+                    t->toklen - t->eq - 1);
             continue;
         }
 
-        if (t->tok[0] == '-') {
+        if (t->dashes == 1) {
             /* Single dash option: -f */
             for (t->c = 1; t->c < t->toklen; t->c++) {
+                STATS_INC(t, probes);
                 t->optioninfo = optiondb_findbykey(t->optiondb, t->tok[t->c]);
                 if (t->optioninfo == NULL) {
                     YIELD_OPT_UNKNOWN(t->tok + t->c, 1);
@@ -188,7 +384,7 @@ tokenizer_next(struct tokenizer *t, struct token *token) {
                 else if (EARG_OPTION_ARGNEEDED(t->optioninfo->option) &&
                         ((t->c + 1) < t->toklen)) {
                     YIELD_OPT(t->optioninfo, t->tok + t->c + 1,
-                            strlen(t->tok + t->c + 1));
+                            t->toklen - t->c - 1);
                     break;
                 }
                 else {
@@ -20,36 +20,104 @@
 #define TOKENIZER_H_
 
 
+#include <stdbool.h>
+
 #include "optiondb.h"
+#include "responsefile.h"
+#include "splitter.h"
+
+
+struct tokenizer {
+    const struct optiondb *optiondb;
+
+    /* source, either argv or a line */
+    int argc;
+    const char **argv;
+    struct splitter splitter;
+
+    /* tokenizer state */
+    int line;
+    int w;
+    int c;
+    int toklen;
+    int eq;
+    unsigned char dashes;
+    const char *tok;
+    const struct optioninfo *optioninfo;
+    bool dashdash;
+
+    /* unique prefixes of long options are accepted */
+    bool abbrev;
+
+#ifdef CONFIG_EARG_STATS
+    /* optiondb lookups */
+    unsigned int probes;
+#endif
+
+#if CONFIG_EARG_RESPONSEFILE_DEPTH
+    /* @file expansion, nested files are split from the innermost one and
+     * all of them are kept until tokenizer_dispose() */
+    bool responsefiles;
+    unsigned char depth;
+    struct splitter responses[CONFIG_EARG_RESPONSEFILE_DEPTH];
+    struct responsefile *files;
+    const struct earg_allocator *allocator;
+
+    /* errno of the failed file, zero if it's nested too deep */
+    int error;
+#endif
+};
 
 
 struct token {
     const char *text;
     unsigned int len;
     const struct optioninfo *optioninfo;
+
+    /* classification of the whole argument */
+    unsigned int arglen;
+    int eq;
+    unsigned char dashes;
 };
 
 
 enum tokenizer_status {
+    EARG_TOK_RESPONSEFILE = -4,
+    EARG_TOK_AMBIGUOUS = -3,
     EARG_TOK_UNKNOWN = -2,
     EARG_TOK_ERROR = -1,
     EARG_TOK_END = 0,
     EARG_TOK_OPTION = 1,
     EARG_TOK_POSITIONAL = 2,
+    EARG_TOK_MORE = 3,
 };
 
 
-struct tokenizer *
-tokenizer_new(int argc, const char **argv,
+void
+tokenizer_init(struct tokenizer *t, int argc, const char **argv,
         const struct optiondb *optdb);
 
 
 void
-tokenizer_dispose(struct tokenizer *t);
+tokenizer_initline(struct tokenizer *t, char *line, size_t len,
+        size_t size, bool eol, const struct optiondb *optdb);
+
+
+void
+tokenizer_optiondb(struct tokenizer *t, const struct optiondb *optdb);
 
 
 enum tokenizer_status
 tokenizer_next(struct tokenizer *t, struct token *token);
 
 
+#if CONFIG_EARG_RESPONSEFILE_DEPTH
+
+/* release the response files */
+void
+tokenizer_dispose(struct tokenizer *t);
+
+#endif
+
+
 #endif  // TOKENIZER_H_
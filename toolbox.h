@@ -43,6 +43,8 @@
         BETWEEN(c, 58, 64) || \
         BETWEEN(c, 123, 126))
 #define ISDIGIT(c) BETWEEN(c, 48, 57)
+#define ISBLANK(c) (((c) == ' ') || ((c) == '\t') || ((c) == '\n') || \
+        ((c) == '\r'))
 #define ISCHAR(c) ((c == '?') || ISDIGIT(c) || \
         BETWEEN(c, 65, 90) || \
         BETWEEN(c, 97, 122))
@@ -0,0 +1,1226 @@
+#! /usr/bin/env python3
+# Copyright 2023 Vahid Mardani
+"""Generate the earg parser tables as const C data.
+
+The command tree is read from a JSON spec and emitted together with the
+compiled plan earg_parse() would otherwise build at runtime: dense option
+ids, perfect hashed and sorted option and choice indexes, sorted
+sub-command dispatch tables, compiled argument hints and the rendered help.
+Everything but the root struct earg is const, so it goes to flash. With
+--compress the help texts are coded against a static dictionary and
+expanded on demand, see CONFIG_EARG_HELP_COMPRESS.
+
+Spec:
+
+    {
+        "symbol": "foo",
+        "includes": ["foo.h"],
+        "version": "1.0.0",
+        "flags": ["noelog"],
+        "envprefix": "FOO_",
+        "configfile": "/etc/foo.conf",
+        "args": "FILE...",
+        "header": "...",
+        "footer": "...",
+        "eat": "foo_eat",
+        "userptr": "&foo_config",
+        "entrypoint": "foo_main",
+        "options": [
+            {"name": "level", "key": "l", "arg": "N", "flags": ["multiple"],
+             "help": "...", "type": "int",
+             "offset": "offsetof(struct foo_config, level)"},
+            {"name": "mode", "key": 1000, "arg": "MODE", "type": "enum",
+             "offset": "offsetof(struct foo_config, mode)",
+             "choices": ["fast", "slow"]},
+            {"name": "Group title", "key": 0}
+        ],
+        "commands": [
+            {"name": "bar", "aliases": ["b"], "args": "...", "options": [],
+             "commands": [], "eat": "...", "userptr": "...",
+             "entrypoint": "..."}
+        ]
+    }
+
+The generated source defines `struct earg <symbol>`, declare it with
+`extern struct earg <symbol>;` and pass it to earg_parse() as usual. The
+source fails to build if the tree exceeds the configured limits, --footprint
+prints the lowest ones for sdkconfig.defaults.
+"""
+import argparse
+import json
+import sys
+from collections import Counter
+
+
+FNV_BASIS = 2166136261
+FNV_PRIME = 16777619
+SEEDS_MAX = 1 << 16
+
+# these must match the C sources
+INDEX_MINOPTIONS = 4
+OPT_MINGAP = 4
+MAXARGS = 30
+MAXCHOICES = 255
+# the range of EARG_OPTIONS_MAX in Kconfig
+OPTIONS_MAX = 254
+DICT_FIRST = 0x80
+DICT_ESCAPE = 0xff
+INT_MIN = -(1 << 31)
+
+FLAGS = {
+    'nohelp': 'EARG_NOHELP',
+    'nousage': 'EARG_NOUSAGE',
+    'noelog': 'EARG_NOELOG',
+    'abbrev': 'EARG_ABBREV',
+    'scoped': 'EARG_SCOPED',
+    'responsefile': 'EARG_RESPONSEFILE',
+}
+
+OPTIONFLAGS = {
+    'multiple': 'EARG_OPTION_MULTIPLE',
+    'inherited': 'EARG_OPTION_INHERITED',
+}
+
+TYPES = {
+    'int': 'EARG_TYPE_INT',
+    'uint': 'EARG_TYPE_UINT',
+    'float': 'EARG_TYPE_FLOAT',
+    'bool': 'EARG_TYPE_BOOL',
+    'size': 'EARG_TYPE_SIZE',
+    'enum': 'EARG_TYPE_ENUM',
+}
+
+
+class SpecError(Exception):
+    pass
+
+
+class Builtin:
+    def __init__(self, symbol, name, key, arg, builtin, help):
+        self.symbol = symbol
+        self.name = name
+        self.key = key
+        self.arg = arg
+        self.builtin = builtin
+        self.help = help
+        self.choices = None
+
+
+# same as builtin.c, in the order plan.c inserts them
+VERSION = Builtin('opt_version', 'version', INT_MIN + 1, None, 'BUILTIN_VERSION',
+                  'Print program version and exit')
+HELP = Builtin('opt_help', 'help', ord('h'), None, 'BUILTIN_HELP',
+               'Give this help list and exit')
+USAGE = Builtin('opt_usage', 'usage', ord('?'), None, 'BUILTIN_USAGE',
+                'Give a short usage message and exit')
+VERBOSITY = Builtin(
+    'opt_verbosity', 'verbosity', INT_MIN + 2, 'LEVEL', 'BUILTIN_VERBOSITY',
+    "Verbosity level. one of: '0|s|silent', '1|f|fatal', '2|e|error', "
+    "'3|w|warn', '4|i|info' and '5|d|debug'. if this option is not given, "
+    "the verbosity level will be '4|i|info'")
+VERBOSER = Builtin('opt_verboseflag', None, ord('v'), None,
+                   'BUILTIN_VERBOSER',
+                   'Increase the elog_verbosity on each occurance, e.g. -vvv')
+QUIETER = Builtin('opt_quietflag', None, ord('q'), None, 'BUILTIN_QUIETER',
+                  'Decrease the elog_verbosity on each occurance, e.g. -qq')
+
+
+def fnv1a(seed, data):
+    h = seed
+    for b in data:
+        h ^= b
+        h = (h * FNV_PRIME) & 0xffffffff
+
+    return h
+
+
+def cstr(s):
+    if s is None:
+        return 'NULL'
+
+    if isinstance(s, str):
+        s = s.encode()
+
+    out = []
+    for b in s:
+        if b == 0x5c:
+            out.append('\\\\')
+        elif b == 0x22:
+            out.append('\\"')
+        elif b == 0x0a:
+            out.append('\\n')
+        elif b == 0x09:
+            out.append('\\t')
+        elif 0x20 <= b < 0x7f:
+            out.append(chr(b))
+        else:
+            out.append('\\%03o' % b)
+
+    return '"%s"' % ''.join(out)
+
+
+def csym(s):
+    return s if s else 'NULL'
+
+
+def signed32(v):
+    return v - (1 << 32) if v & (1 << 31) else v
+
+
+ARGSMASK = (1 << MAXARGS) - 1
+
+
+def arghint(args):
+    """Port of arghint_parse(), -1 leaves the count unvalidated."""
+    if not args:
+        return 1
+
+    if '\n' not in args:
+        return arghint_line(args)
+
+    bits = 0
+    for line in args.rstrip('\n').split('\n'):
+        pattern = arghint_line(line)
+        if pattern == -1:
+            return -1
+
+        # counts above the highest one of a variadic line are accepted
+        if pattern < 0:
+            lastbit = (pattern & ARGSMASK).bit_length() - 1
+            pattern |= ARGSMASK & ~((2 << lastbit) - 1)
+
+        bits |= pattern & 0xffffffff
+
+    return signed32(bits)
+
+
+def arghint_line(args):
+    b = args.encode()
+
+    def nexttok(pos):
+        while pos < len(b) and b[pos] == 0x20:
+            pos += 1
+
+        if pos >= len(b):
+            return None
+
+        end = pos
+        while end < len(b) and b[end] != 0x20:
+            end += 1
+
+        return pos, end - pos
+
+    tok = nexttok(0)
+    if tok is None:
+        return -1
+
+    counter = bits = opens = 0
+    while tok:
+        start, toklen = tok
+        t = b[start:start + toklen]
+        if t[0] == ord('['):
+            bits |= 1 << counter
+            opens += 1
+
+        counter += 1
+        if counter > MAXARGS:
+            return -1
+
+        i = toklen - 1
+        if t[i] != ord(']') and i > 3 and t[i - 3] == ord(']'):
+            i -= 3
+
+        while i > 0 and t[i] == ord(']'):
+            opens -= 1
+            i -= 1
+
+        dots = t.find(b'...')
+        if dots >= 0:
+            if toklen - dots > 3:
+                return -1
+
+            bits |= 1 << (counter - 1 if dots == 0 else counter)
+            bits |= 1 << 31
+            return signed32(bits)
+
+        tok = nexttok(start + toklen)
+
+    if opens:
+        return -1
+
+    bits |= 1 << counter
+    return signed32(bits)
+
+
+def helplen(name, arg):
+    if name is None:
+        return 0
+
+    return len(name.encode()) + (len(arg.encode()) + 1 if arg else 0)
+
+
+def pad(width):
+    """printf("%*s", width, "")"""
+    return b' ' * abs(width)
+
+
+def ischar(key):
+    return key is not None and (key == ord('?') or
+                                ord('0') <= key <= ord('9') or
+                                ord('A') <= key <= ord('Z') or
+                                ord('a') <= key <= ord('z'))
+
+
+def issign(c):
+    return 32 <= c <= 47 or 58 <= c <= 64 or 123 <= c <= 126
+
+
+def multiline(string, indent, linemax):
+    """Port of _print_multiline()."""
+    out = b''
+    if string is None:
+        return out
+
+    s = string.encode()
+    linesize = linemax - indent
+    if linesize < 2:
+        raise SpecError('help line size is too small')
+
+    pos = 0
+    remain = len(s)
+    while remain:
+        dash = False
+        while remain and s[pos] in b' \t\n\v\f\r':
+            pos += 1
+            remain -= 1
+
+        if remain <= linesize:
+            out += s[pos:] + b'\n'
+            break
+
+        ls = linesize
+        if s[pos + ls - 2] == 0x20:
+            ls -= 1
+        elif s[pos + ls - 1] != 0x20 and s[pos + ls] != 0x20 and \
+                not issign(s[pos + ls - 1]) and not issign(s[pos + ls]):
+            ls -= 1
+            dash = True
+
+        if s[pos + ls - 1] == 0x20:
+            ls -= 1
+
+        out += s[pos:pos + ls] + (b'-' if dash else b'') + b'\n'
+        remain -= ls
+        pos += ls
+        out += pad(indent)
+
+    return out
+
+
+def sortedby(names):
+    """Indexes of the names in strcmp() order."""
+    return sorted(range(len(names)), key=lambda i: names[i].encode())
+
+
+def perfecthash(names, minsize):
+    """Returns (size, seed, slots) of a collision free open addressing
+    table, slots are keyed by hash & (size - 1) and store index + 1."""
+    size = 2
+    while size < minsize:
+        size <<= 1
+
+    while True:
+        for seed in range(FNV_BASIS, FNV_BASIS + SEEDS_MAX):
+            slots = [0] * size
+            for i, name in enumerate(names):
+                h = fnv1a(seed & 0xffffffff, name.encode()) & (size - 1)
+                if slots[h]:
+                    break
+
+                slots[h] = i + 1
+            else:
+                return size, seed & 0xffffffff, slots
+
+        size <<= 1
+
+
+class Dictionary:
+    """Static dictionary for the help texts, greedily picks the substrings
+    saving the most bytes. Compressed texts refer to the entries by
+    DICT_FIRST + index and escape the other non-ascii bytes by
+    DICT_ESCAPE."""
+    MAXENTRIES = DICT_ESCAPE - DICT_FIRST
+    MINLEN = 3
+    MAXLEN = 24
+    PERROUND = 8
+
+    def __init__(self, texts):
+        self.entries = []
+        texts = [[t] for t in texts if t]
+
+        while len(self.entries) < self.MAXENTRIES:
+            picked = self._pick(texts)
+            if not picked:
+                break
+
+            for entry in picked:
+                self.entries.append(entry)
+                texts = [self._split(t, entry, len(self.entries) - 1)
+                         for t in texts]
+
+    @staticmethod
+    def _overlaps(a, b):
+        if a in b or b in a:
+            return True
+
+        for i in range(1, min(len(a), len(b))):
+            if a[-i:] == b[:i] or b[-i:] == a[:i]:
+                return True
+
+        return False
+
+    def _pick(self, texts):
+        counts = Counter()
+        for segments in texts:
+            for s in segments:
+                if isinstance(s, int):
+                    continue
+
+                for i in range(len(s) - self.MINLEN + 1):
+                    for j in range(i + self.MINLEN,
+                                   min(i + self.MAXLEN, len(s)) + 1):
+                        counts[s[i:j]] += 1
+
+        # each entry costs itself, the terminator and a pointer
+        candidates = sorted(((c * (len(s) - 1) - len(s) - 5, s)
+                             for s, c in counts.items() if c > 1),
+                            reverse=True)
+        picked = []
+        room = self.MAXENTRIES - len(self.entries)
+        for gain, s in candidates:
+            if (gain <= 0) or (len(picked) == min(room, self.PERROUND)):
+                break
+
+            if not any(self._overlaps(s, p) for p in picked):
+                picked.append(s)
+
+        return picked
+
+    @staticmethod
+    def _split(segments, entry, index):
+        out = []
+        for s in segments:
+            if isinstance(s, int):
+                out.append(s)
+                continue
+
+            for i, part in enumerate(s.split(entry)):
+                if i:
+                    out.append(index)
+                if part:
+                    out.append(part)
+
+        return out
+
+    def encode(self, text):
+        segments = [text]
+        for i, entry in enumerate(self.entries):
+            segments = self._split(segments, entry, i)
+
+        out = bytearray()
+        for s in segments:
+            if isinstance(s, int):
+                out.append(DICT_FIRST + s)
+                continue
+
+            for b in s:
+                if b >= DICT_FIRST:
+                    out.append(DICT_ESCAPE)
+                out.append(b)
+
+        return bytes(out)
+
+
+class Option:
+    def __init__(self, spec, command):
+        self.spec = spec
+        self.command = command
+        self.name = spec.get('name')
+        if not self.name:
+            raise SpecError('option without name')
+
+        key = spec.get('key', 0)
+        if isinstance(key, str):
+            if len(key) != 1:
+                raise SpecError('invalid key -- %r' % key)
+            key = ord(key)
+        self.key = key
+        self.arg = spec.get('arg')
+        self.help = spec.get('help')
+        self.flags = [self._map(OPTIONFLAGS, f, 'option flag')
+                      for f in spec.get('flags', [])]
+        self.type = spec.get('type')
+        if self.type is not None:
+            self._map(TYPES, self.type, 'type')
+        self.offset = spec.get('offset')
+        self.choices = spec.get('choices')
+        self.builtin = None
+
+    @staticmethod
+    def _map(table, value, what):
+        try:
+            return table[value]
+        except KeyError:
+            raise SpecError('invalid %s -- %r' % (what, value))
+
+    def validate(self):
+        if self.type is None:
+            return
+
+        if not self.command.userptr:
+            raise SpecError("typed option without userptr -- '--%s'" %
+                            self.name)
+
+        if self.offset is None:
+            raise SpecError("typed option without offset -- '--%s'" %
+                            self.name)
+
+        if self.type != 'enum':
+            return
+
+        if not self.choices or len(self.choices) > MAXCHOICES:
+            raise SpecError("invalid choices for option -- '--%s'" %
+                            self.name)
+
+        if len(set(self.choices)) != len(self.choices):
+            raise SpecError("choice duplicated for option -- '--%s'" %
+                            self.name)
+
+
+class Command:
+    def __init__(self, spec, parent=None, root=None):
+        self.spec = spec
+        self.parent = parent
+        self.root = root or self
+        self.name = spec.get('name')
+        if parent and not self.name:
+            raise SpecError('command without name')
+
+        self.aliases = spec.get('aliases', [])
+        self.args = spec.get('args')
+        self.header = spec.get('header')
+        self.footer = spec.get('footer')
+        self.eat = spec.get('eat')
+        self.userptr = spec.get('userptr')
+        self.entrypoint = spec.get('entrypoint')
+        self.options = [Option(o, self) for o in spec.get('options', [])]
+        self.commands = [Command(c, self, self.root)
+                         for c in spec.get('commands', [])]
+
+    def walk(self):
+        yield self
+        for c in self.commands:
+            yield from c.walk()
+
+
+class Node:
+    def __init__(self, command, parent):
+        self.command = command
+        self.parent = parent
+        self.index = None
+        self.infos = []
+        self.infosoffset = 0
+        self.base = parent.base + len(parent.infos) if parent else 0
+        self.children = []
+        self.entries = []
+        self.entriesoffset = 0
+        self.nameindex = None
+
+    def find(self, info):
+        """In this scope only, the parents' options are shadowed."""
+        for i in self.infos:
+            if (info.key and i.key == info.key) or \
+                    (info.name and i.name == info.name):
+                return i
+
+        return None
+
+
+class Generator:
+    def __init__(self, spec, linesize, compress=False):
+        self.spec = spec
+        self.linesize = linesize
+        self.compress = compress
+        self.dictionary = None
+        self.symbol = spec.get('symbol')
+        if not self.symbol:
+            raise SpecError('symbol is required')
+
+        self.version = spec.get('version')
+        self.envprefix = spec.get('envprefix')
+        self.configfile = spec.get('configfile')
+        self.flags = [Option._map(FLAGS, f, 'flag')
+                      for f in spec.get('flags', [])]
+        self.root = Command(spec)
+        self.nodes = []
+        self.infos = []
+        self.entries = []
+        self.depth = 0
+        self.idsmax = 0
+        self.out = []
+
+    def hasflag(self, flag):
+        return flag in self.flags
+
+    def inherited(self, info):
+        return isinstance(info, Builtin) or \
+            not self.hasflag('EARG_SCOPED') or \
+            'EARG_OPTION_INHERITED' in info.flags
+
+    def builtins(self):
+        builtins = []
+        if self.version:
+            builtins.append(VERSION)
+
+        if not self.hasflag('EARG_NOHELP'):
+            builtins.append(HELP)
+
+        if not self.hasflag('EARG_NOUSAGE'):
+            builtins.append(USAGE)
+
+        if not self.hasflag('EARG_NOELOG'):
+            builtins += [VERBOSITY, VERBOSER, QUIETER]
+
+        return builtins
+
+    def gapsize(self, command, subcommand):
+        """Port of help_gapsize()."""
+        gapsize = 8
+
+        if not subcommand and not self.hasflag('EARG_NOELOG'):
+            for b in (VERBOSITY, VERBOSER, QUIETER):
+                gapsize = max(gapsize, helplen(b.name, b.arg) + OPT_MINGAP)
+
+        if not self.hasflag('EARG_NOHELP'):
+            gapsize = max(gapsize, helplen(HELP.name, None) + OPT_MINGAP)
+
+        if not self.hasflag('EARG_NOUSAGE'):
+            gapsize = max(gapsize, helplen(USAGE.name, None) + OPT_MINGAP)
+
+        if self.version:
+            gapsize = max(gapsize, helplen(VERSION.name, None) + OPT_MINGAP)
+
+        for o in command.options:
+            gapsize = max(gapsize, helplen(o.name, o.arg) + OPT_MINGAP)
+
+        return gapsize
+
+    def render_option(self, o, gapsize):
+        """Port of _print_option() and _print_optiongroup()."""
+        out = b''
+        if o.key:
+            rpad = gapsize - helplen(o.name, o.arg)
+            if ischar(o.key):
+                out += b'  -%c%c ' % (o.key, ord(',') if o.name else 0x20)
+            else:
+                out += b'      '
+
+            if o.name and o.arg is None:
+                out += b'--' + o.name.encode() + pad(rpad)
+            elif o.name:
+                out += b'--%s=%s' % (o.name.encode(), o.arg.encode()) + \
+                    pad(rpad)
+            else:
+                out += b'  ' + pad(rpad)
+        elif o.name != '-':
+            rpad = gapsize + 8 - len(o.name.encode())
+            out += b'\n' + o.name.encode() + pad(rpad)
+
+        if o.help is not None:
+            return out + multiline(o.help, gapsize + 8, self.linesize)
+
+        return out + b'\n'
+
+    def render(self, node):
+        """Port of _print_body(), the help except the usage lines."""
+        command = node.command
+        subcommand = node.parent is not None
+        out = b''
+
+        if command.header is not None:
+            out += b'\n' + multiline(command.header, 0, self.linesize)
+
+        if command.commands:
+            out += b'\nCommands:\n'
+            for c in command.commands:
+                out += b'  ' + c.name.encode()
+                for a in c.aliases:
+                    out += b', ' + a.encode()
+                out += b'\n'
+
+        out += b'\nOptions:\n'
+        builtins = []
+        if not self.hasflag('EARG_NOHELP'):
+            builtins.append(HELP)
+
+        if not self.hasflag('EARG_NOUSAGE'):
+            builtins.append(USAGE)
+
+        if not subcommand and not self.hasflag('EARG_NOELOG'):
+            builtins += [VERBOSER, QUIETER, VERBOSITY]
+
+        if not subcommand and self.version:
+            builtins.append(VERSION)
+
+        for b in builtins:
+            out += self.render_option(b, node.gapsize)
+
+        for o in command.options:
+            out += self.render_option(o, node.gapsize)
+
+        if command.footer is not None:
+            out += b'\n' + multiline(command.footer, 0, self.linesize)
+
+        return out
+
+    def insert(self, node, info):
+        if node.find(info):
+            name = '-%c' % info.key if ischar(info.key) else ''
+            if info.name:
+                name += '%s--%s' % ('/' if name else '', info.name)
+            raise SpecError("option duplicated -- '%s'" % name)
+
+        info.id = node.base + len(node.infos)
+        node.infos.append(info)
+        self.idsmax = max(self.idsmax, info.id + 1)
+        if self.idsmax > OPTIONS_MAX:
+            raise SpecError('too many options over a command path')
+
+    def build(self, node, depth):
+        """Same layout as plan_compile()."""
+        command = node.command
+        self.depth = max(self.depth, depth)
+        node.arghint = arghint(command.args)
+        node.gapsize = self.gapsize(command, node.parent is not None)
+        node.help = self.render(node)
+
+        node.infosoffset = len(self.infos)
+        if node.parent is None:
+            for b in self.builtins():
+                self.insert(node, b)
+
+        for o in command.options:
+            o.validate()
+            if o.key:
+                self.insert(node, o)
+        self.infos += node.infos
+
+        if len(node.infos) >= INDEX_MINOPTIONS:
+            names = [i.name for i in node.infos if i.name]
+            size, seed, slots = perfecthash(names, len(node.infos) * 2)
+            named = [i for i in node.infos if i.name]
+            node.nameindex = (size, seed, [
+                node.infos.index(named[s - 1]) + 1 if s else 0
+                for s in slots])
+
+        # children are contiguous
+        for c in command.commands:
+            child = Node(c, node)
+            node.children.append(child)
+        node.childrenoffset = len(self.nodes)
+        self.nodes += node.children
+
+        for child in node.children:
+            self.build(child, depth + 1)
+
+        for i, child in enumerate(node.children):
+            node.entries.append((child.command.name, child))
+            for a in child.command.aliases:
+                node.entries.append((a, child))
+
+        node.entries.sort(key=lambda e: e[0].encode())
+        for a, b in zip(node.entries, node.entries[1:]):
+            if a[0] == b[0]:
+                raise SpecError("command duplicated -- '%s'" % a[0])
+
+        node.entriesoffset = len(self.entries)
+        self.entries += node.entries
+
+    def compile(self):
+        rootnode = Node(self.root, None)
+        self.nodes.append(rootnode)
+        self.build(rootnode, 1)
+
+        if not self.compress:
+            return
+
+        texts = [n.help for n in self.nodes]
+        for c in self.root.walk():
+            texts += [t.encode() for t in [c.header, c.footer] if t]
+            texts += [o.help.encode() for o in c.options if o.help]
+        self.dictionary = Dictionary(texts)
+        self.textmax = max(len(t) for t in texts[len(self.nodes):] or [b''])
+
+    def text(self, s):
+        """Help texts as C literals, compressed if asked."""
+        if s is None:
+            return 'NULL'
+
+        if isinstance(s, str):
+            s = s.encode()
+
+        if self.dictionary:
+            s = self.dictionary.encode(s)
+
+        return cstr(s)
+
+    # emitters
+    def emit(self, line=''):
+        self.out.append(line)
+
+    def commandsymbol(self, command):
+        if command is self.root:
+            return '(const struct earg_command *)&%s' % self.symbol
+
+        return '&%s_command_%d' % (self.symbol, self.commandid(command))
+
+    def commandid(self, command):
+        return list(self.root.walk()).index(command)
+
+    def emit_prototypes(self):
+        eaters = set()
+        entrypoints = set()
+        for c in self.root.walk():
+            if c.eat:
+                eaters.add(c.eat)
+            if c.entrypoint:
+                entrypoints.add(c.entrypoint)
+
+        for e in sorted(eaters):
+            self.emit('enum earg_eatstatus')
+            self.emit('%s(const struct earg_option *option, '
+                      'const char *value,' % e)
+            self.emit('        void *userptr);')
+            self.emit()
+            self.emit()
+
+        for e in sorted(entrypoints):
+            self.emit('int')
+            self.emit('%s(const struct earg *c, '
+                      'const struct earg_command *cmd);' % e)
+            self.emit()
+            self.emit()
+
+    def emit_options(self, command):
+        cid = self.commandid(command)
+        for i, o in enumerate(command.options):
+            if o.choices:
+                self.emit('static const char * const %s_choices_%d_%d[] = {'
+                          % (self.symbol, cid, i))
+                for c in o.choices:
+                    self.emit('    %s,' % cstr(c))
+                self.emit('    NULL')
+                self.emit('};')
+                self.emit()
+                self.emit()
+
+        if not command.options:
+            return
+
+        self.emit('static const struct earg_option %s_options_%d[] = {' %
+                  (self.symbol, cid))
+        for i, o in enumerate(command.options):
+            self.emit('    {')
+            self.emit('        .name = %s,' % cstr(o.name))
+            self.emit('        .key = %s,' % self.key(o.key))
+            self.emit('        .arg = %s,' % cstr(o.arg))
+            self.emit('        .flags = %s,' %
+                      (' | '.join(o.flags) if o.flags else 'EARG_OPTION_NONE'))
+            self.emit('        .help = %s,' % self.text(o.help))
+            if o.type:
+                self.emit('        .type = %s,' % TYPES[o.type])
+                self.emit('        .offset = %s,' % o.offset)
+            if o.choices:
+                self.emit('        .choices = %s_choices_%d_%d,' %
+                          (self.symbol, cid, i))
+            self.emit('    },')
+        self.emit('    {NULL}')
+        self.emit('};')
+        self.emit()
+        self.emit()
+
+    @staticmethod
+    def key(key):
+        if 0x20 < key < 0x7f and chr(key) not in '\\\'':
+            return "'%s'" % chr(key)
+
+        return str(key)
+
+    def emit_commandfields(self, command, indent):
+        cid = self.commandid(command)
+        pad = ' ' * indent
+        self.emit('%s.name = %s,' % (pad, cstr(command.name)))
+        if command.options:
+            self.emit('%s.options = %s_options_%d,' % (pad, self.symbol, cid))
+        if command.commands:
+            self.emit('%s.commands = (const struct earg_command **)'
+                      '%s_commands_%d,' % (pad, self.symbol, cid))
+        self.emit('%s.args = %s,' % (pad, cstr(command.args)))
+        self.emit('%s.header = %s,' % (pad, self.text(command.header)))
+        self.emit('%s.footer = %s,' % (pad, self.text(command.footer)))
+        self.emit('%s.eat = %s,' % (pad, csym(command.eat)))
+        self.emit('%s.userptr = %s,' % (pad, csym(command.userptr)))
+        self.emit('%s.entrypoint = %s,' % (pad, csym(command.entrypoint)))
+        if command.aliases:
+            self.emit('%s.aliases = %s_aliases_%d,' % (pad, self.symbol, cid))
+
+    def emit_command(self, command):
+        """Children first, they are referenced by the parent."""
+        cid = self.commandid(command)
+        for c in command.commands:
+            self.emit_command(c)
+
+        self.emit_options(command)
+        if command.aliases:
+            self.emit('static const char * const %s_aliases_%d[] = {' %
+                      (self.symbol, cid))
+            for a in command.aliases:
+                self.emit('    %s,' % cstr(a))
+            self.emit('    NULL')
+            self.emit('};')
+            self.emit()
+            self.emit()
+
+        if command.commands:
+            self.emit('static const struct earg_command * const '
+                      '%s_commands_%d[] = {' % (self.symbol, cid))
+            for c in command.commands:
+                self.emit('    %s,' % self.commandsymbol(c))
+            self.emit('    NULL')
+            self.emit('};')
+            self.emit()
+            self.emit()
+
+        if command is self.root:
+            return
+
+        self.emit('static const struct earg_command %s_command_%d = {' %
+                  (self.symbol, cid))
+        self.emit_commandfields(command, 4)
+        self.emit('};')
+        self.emit()
+        self.emit()
+
+    def emit_root(self):
+        self.emit('struct earg %s = {' % self.symbol)
+        self.emit_commandfields(self.root, 4)
+        self.emit('    .version = %s,' % cstr(self.version))
+        self.emit('    .flags = %s,' %
+                  (' | '.join(self.flags) if self.flags else '0'))
+        if self.envprefix:
+            self.emit('    .envprefix = %s,' % cstr(self.envprefix))
+        if self.configfile:
+            self.emit('    .configfile = %s,' % cstr(self.configfile))
+        if self.dictionary:
+            self.emit('    .dictionary = %s_dictionary,' % self.symbol)
+        self.emit('    .state = NULL,')
+        self.emit('    .plan = (struct earg_plan *)&%s_plan,' % self.symbol)
+        self.emit('};')
+        self.emit()
+        self.emit()
+
+    def optionsymbol(self, info):
+        if isinstance(info, Builtin):
+            return '&%s' % info.symbol
+
+        cid = self.commandid(info.command)
+        return '%s_options_%d + %d' % (self.symbol, cid,
+                                       info.command.options.index(info))
+
+    def emit_choiceindexes(self):
+        for n, info in enumerate(self.infos):
+            if info.choices is None or info.type != 'enum':
+                continue
+
+            size, seed, slots = perfecthash(info.choices,
+                                            len(info.choices) * 2)
+            self.emit('static const unsigned char %s_choicesorted_%d[] = {%s};'
+                      % (self.symbol, n, ', '.join(
+                          str(i) for i in sortedby(info.choices))))
+            self.emit()
+            self.emit('static const struct choiceindex %s_choiceindex_%d = {'
+                      % (self.symbol, n))
+            self.emit('    .mask = %d,' % (size - 1))
+            self.emit('    .seed = %du,' % seed)
+            self.emit('    .count = %d,' % len(info.choices))
+            self.emit('    .sorted = %s_choicesorted_%d,' % (self.symbol, n))
+            self.emit('    .slots = {%s},' % ', '.join(str(s) for s in slots))
+            self.emit('};')
+            self.emit()
+            self.emit()
+
+    def emit_infos(self):
+        self.emit('static const struct optioninfo %s_infos[] = {' %
+                  self.symbol)
+        for n, info in enumerate(self.infos):
+            if isinstance(info, Builtin):
+                command = self.commandsymbol(self.root)
+            else:
+                command = self.commandsymbol(info.command)
+
+            self.emit('    {')
+            self.emit('        .option = %s,' % self.optionsymbol(info))
+            self.emit('        .command = %s,' % command)
+            self.emit('        .namelen = %d,' %
+                      (len(info.name.encode()) if info.name else 0))
+            self.emit('        .id = %d,' % info.id)
+            if isinstance(info, Builtin):
+                self.emit('        .builtin = %s,' % info.builtin)
+            self.emit('        .inherited = %s,' %
+                      ('true' if self.inherited(info) else 'false'))
+            if info.choices is not None and info.type == 'enum':
+                self.emit('        .choices = &%s_choiceindex_%d,' %
+                          (self.symbol, n))
+            self.emit('    },')
+
+        if not self.infos:
+            self.emit('    {NULL}')
+        self.emit('};')
+        self.emit()
+        self.emit()
+
+    def emit_indexes(self):
+        self.emit('#ifdef CONFIG_EARG_OPTIONDB_INDEX')
+        self.emit()
+        for n, node in enumerate(self.nodes):
+            if node.nameindex is None:
+                continue
+
+            size, seed, slots = node.nameindex
+            keys = ['[%d] = %d' % (info.key, i + 1)
+                    for i, info in enumerate(node.infos)
+                    if info.key and 0 < info.key < 256]
+            self.emit('static const struct optionindex %s_index_%d = {' %
+                      (self.symbol, n))
+            self.emit('    .keys = {%s},' % ', '.join(keys))
+            self.emit('    .mask = %d,' % (size - 1))
+            self.emit('    .seed = %du,' % seed)
+            self.emit('    .names = {%s},' % ', '.join(str(s) for s in slots))
+            self.emit('};')
+            self.emit()
+
+        self.emit('#endif')
+        self.emit()
+        self.emit()
+
+    def emit_sorted(self):
+        for n, node in enumerate(self.nodes):
+            named = [i for i in node.infos if i.name]
+            if not named:
+                continue
+
+            self.emit('static const unsigned char %s_sorted_%d[] = {%s};' %
+                      (self.symbol, n, ', '.join(
+                          str(node.infos.index(named[i]))
+                          for i in sortedby([i.name for i in named]))))
+        self.emit()
+        self.emit()
+
+    def emit_entries(self):
+        self.emit('static const struct planentry %s_entries[] = {' %
+                  self.symbol)
+        for name, node in self.entries:
+            self.emit('    {%s, %s_nodes + %d},' %
+                      (cstr(name), self.symbol, self.nodes.index(node)))
+        if not self.entries:
+            self.emit('    {NULL}')
+        self.emit('};')
+        self.emit()
+        self.emit()
+
+    def emit_nodes(self):
+        self.emit('static const struct plannode %s_nodes[] = {' % self.symbol)
+        for n, node in enumerate(self.nodes):
+            self.emit('    {')
+            self.emit('        .command = %s,' %
+                      self.commandsymbol(node.command))
+            if node.parent:
+                parent = self.nodes.index(node.parent)
+                self.emit('        .parent = %s_nodes + %d,' %
+                          (self.symbol, parent))
+            self.emit('        .optiondb = {')
+            if node.parent:
+                self.emit('            .parent = &%s_nodes[%d].optiondb,' %
+                          (self.symbol, parent))
+            self.emit('            .repo = (struct optioninfo *)%s_infos + %d,'
+                      % (self.symbol, node.infosoffset))
+            self.emit('            .size = %d,' % len(node.infos))
+            self.emit('            .count = %d,' % len(node.infos))
+            self.emit('            .base = %d,' % node.base)
+            if node.nameindex:
+                self.emit('#ifdef CONFIG_EARG_OPTIONDB_INDEX')
+                self.emit('            .index = (struct optionindex *)'
+                          '&%s_index_%d,' % (self.symbol, n))
+                self.emit('#endif')
+            named = [i for i in node.infos if i.name]
+            if named:
+                self.emit('            .sorted = %s_sorted_%d,' %
+                          (self.symbol, n))
+                self.emit('            .sortedcount = %d,' % len(named))
+            self.emit('        },')
+            self.emit('        .arghint = %d,' % node.arghint)
+            if node.children:
+                self.emit('        .children = %s_nodes + %d,' %
+                          (self.symbol, node.childrenoffset))
+                self.emit('        .childrencount = %d,' % len(node.children))
+                self.emit('        .dispatch = %s_entries + %d,' %
+                          (self.symbol, node.entriesoffset))
+                self.emit('        .dispatchcount = %d,' % len(node.entries))
+            self.emit('        .gapsize = %d,' % node.gapsize)
+            self.emit('#ifdef CONFIG_EARG_HELP_CACHE')
+            self.emit('        .help =')
+            helptext = node.help
+            if self.dictionary:
+                helptext = self.dictionary.encode(helptext)
+            lines = helptext.split(b'\n')
+            for i, line in enumerate(lines[:-1]):
+                self.emit('            %s%s' % (cstr(line + b'\n'),
+                          ',' if i == len(lines) - 2 and not lines[-1]
+                          else ''))
+            if lines[-1]:
+                self.emit('            %s,' % cstr(lines[-1]))
+            self.emit('        .helplen = %d,' % len(helptext))
+            self.emit('#endif')
+            self.emit('    },')
+        self.emit('};')
+        self.emit()
+        self.emit()
+
+    def footprint(self):
+        """The lowest limits the tree fits in, as sdkconfig lines, see
+        earg_footprint()."""
+        self.compile()
+        return 'CONFIG_EARG_OPTIONS_MAX=%d\nCONFIG_EARG_CMDSTACK_MAX=%d\n' % \
+            (self.idsmax, self.depth)
+
+    def generate(self, source):
+        self.compile()
+
+        self.emit('/* Generated by earggen.py from %s, do not edit. */' %
+                  source)
+        self.emit('#include <stddef.h>')
+        self.emit('#include <stdbool.h>')
+        self.emit()
+        for i in self.spec.get('includes', []):
+            self.emit('#include "%s"' % i)
+        self.emit('#include "earg.h"')
+        self.emit('#include "builtin.h"')
+        self.emit('#include "binding.h"')
+        self.emit('#include "optiondb.h"')
+        self.emit('#include "plan.h"')
+        self.emit()
+        self.emit()
+        self.emit('_Static_assert(%d <= CONFIG_EARG_CMDSTACK_MAX,' %
+                  self.depth)
+        self.emit('        "%s: maximum allowed command chain length is '
+                  'exceeded");' % self.symbol)
+        self.emit('_Static_assert(%d <= CONFIG_EARG_OPTIONS_MAX,' %
+                  self.idsmax)
+        self.emit('        "%s: maximum allowed options are exceeded");' %
+                  self.symbol)
+        self.emit('#ifdef CONFIG_EARG_HELP_CACHE')
+        self.emit('_Static_assert(CONFIG_EARG_HELP_LINESIZE == %d,' %
+                  self.linesize)
+        self.emit('        "%s: help is rendered for another line size");' %
+                  self.symbol)
+        self.emit('#endif')
+        if self.dictionary:
+            self.emit('#ifndef CONFIG_EARG_HELP_COMPRESS')
+            self.emit('#error "%s: help texts are compressed, enable '
+                      'CONFIG_EARG_HELP_COMPRESS"' % self.symbol)
+            self.emit('#endif')
+            self.emit('_Static_assert(%d < CONFIG_EARG_HELP_COMPRESS_BUFFSIZE,'
+                      % self.textmax)
+            self.emit('        "%s: help text is too long to expand");' %
+                      self.symbol)
+        self.emit()
+        self.emit()
+        self.emit('static const struct earg_plan %s_plan;' % self.symbol)
+        self.emit('static const struct plannode %s_nodes[%d];' %
+                  (self.symbol, len(self.nodes)))
+        self.emit()
+        self.emit()
+        self.emit_prototypes()
+        if self.dictionary:
+            self.emit('static const char * const %s_dictionary[] = {' %
+                      self.symbol)
+            for entry in self.dictionary.entries:
+                self.emit('    %s,' % cstr(entry))
+            self.emit('};')
+            self.emit()
+            self.emit()
+        self.emit_command(self.root)
+        self.emit_root()
+        self.emit_choiceindexes()
+        self.emit_infos()
+        self.emit_indexes()
+        self.emit_sorted()
+        self.emit_entries()
+        self.emit_nodes()
+        self.emit('static const struct earg_plan %s_plan = {' % self.symbol)
+        self.emit('    .rodata = true,')
+        self.emit('    .nodes = (struct plannode *)%s_nodes,' % self.symbol)
+        self.emit('    .nodescount = %d,' % len(self.nodes))
+        self.emit('    .infos = (struct optioninfo *)%s_infos,' % self.symbol)
+        self.emit('    .infoscount = %d,' % len(self.infos))
+        self.emit('    .entries = (struct planentry *)%s_entries,' %
+                  self.symbol)
+        self.emit('    .entriescount = %d,' % len(self.entries))
+        if self.dictionary:
+            self.emit('    .dictionary = %s_dictionary,' % self.symbol)
+        self.emit('};')
+
+        return '\n'.join(self.out) + '\n'
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('spec', help='JSON command spec')
+    parser.add_argument('-o', '--output', help='output C file, default: '
+                        'stdout')
+    parser.add_argument('-l', '--linesize', type=int, default=79,
+                        help='CONFIG_EARG_HELP_LINESIZE, default: 79')
+    parser.add_argument('-c', '--compress', action='store_true',
+                        help='compress the help texts, requires '
+                        'CONFIG_EARG_HELP_COMPRESS')
+    parser.add_argument('-f', '--footprint', action='store_true',
+                        help='print the lowest CONFIG_EARG_OPTIONS_MAX and '
+                        'CONFIG_EARG_CMDSTACK_MAX for the tree, in '
+                        'sdkconfig format, instead of the source')
+    args = parser.parse_args()
+
+    with open(args.spec) as f:
+        spec = json.load(f)
+
+    try:
+        generator = Generator(spec, args.linesize, args.compress)
+        if args.footprint:
+            source = generator.footprint()
+        else:
+            source = generator.generate(args.spec)
+    except SpecError as e:
+        print('%s: %s' % (args.spec, e), file=sys.stderr)
+        return 1
+
+    if args.output is None:
+        sys.stdout.write(source)
+        return 0
+
+    with open(args.output, 'w') as f:
+        f.write(source)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())